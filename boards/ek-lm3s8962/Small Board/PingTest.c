@@ -27,8 +27,7 @@ int Ping(void) //Add code to test Ping functions
 {
 
 
-	Ping_Init(TIMER2_BASE, TIMER_A); //Must do this after OS_AddPeriodicThread in order
-	//to set the correct timer 2A prescale
+	Ping_Init(1); //pingProducer runs from the Timer3A interrupt
 
 
 }
@@ -68,7 +67,7 @@ void Interpreter(void);
 unsigned long testFifoData = 0;
 void FifoProducer(void)
 {
-	TimerIntClear(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
+	TimerIntClear(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
 	Ping_Fifo_Put(testFifoData);
 	testFifoData++;
 }
@@ -91,21 +90,21 @@ int fifomain(void)
 	Ping_Fifo_Init();
 
 	SysCtlClockSet(SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_8MHZ);
-	SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER2);
-	TimerConfigure(TIMER2_BASE, TIMER_CFG_16_BIT_PAIR | TIMER_CFG_A_PERIODIC | TIMER_CFG_B_PERIODIC);
+	SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER3);
+	TimerConfigure(TIMER3_BASE, TIMER_CFG_16_BIT_PAIR | TIMER_CFG_A_PERIODIC | TIMER_CFG_B_PERIODIC);
 
-	TimerPrescaleSet(TIMER2_BASE, TIMER_A, 0);
-	TimerLoadSet(TIMER2_BASE, TIMER_A, 50000); 
+	TimerPrescaleSet(TIMER3_BASE, TIMER_A, 0);
+	TimerLoadSet(TIMER3_BASE, TIMER_A, 50000); 
 	
 	//Set timer to interrupt and set priority
-	IntEnable(INT_TIMER2A);
+	IntEnable(INT_TIMER3A);
 	priority = 0;
 	priority = priority << 5;
-	IntPrioritySet(INT_TIMER2A, priority);
-	TimerIntEnable(TIMER2_BASE, TIMER_TIMA_TIMEOUT); 
+	IntPrioritySet(INT_TIMER3A, priority);
+	TimerIntEnable(TIMER3_BASE, TIMER_TIMA_TIMEOUT); 
 
 	//Enable the timer    
-	TimerEnable(TIMER2_BASE, TIMER_A);
+	TimerEnable(TIMER3_BASE, TIMER_A);
 
 	while(1)
 	{
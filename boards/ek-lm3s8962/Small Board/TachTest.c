@@ -28,11 +28,6 @@
 unsigned long PIDWork;      // current number of PID calculations finished
 unsigned long FilterWork;   // number of digital filter calculations finished
 
-extern unsigned long JitterHistogramA[];
-extern unsigned long JitterHistogramB[];
-extern long MaxJitterA;
-extern long MinJitterA;
-
 unsigned short SoundVFreq = 1;
 unsigned short SoundVTime = 0;
 unsigned short FilterOn = 1;
@@ -75,7 +70,7 @@ void SmallBoardInit(){
 	IntMasterDisable();
 	// Set the clocking to run from PLL at 50 MHz 
 	SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_8MHZ);
-	Tach_Init(2);
+	Tach_Init(0);	// above OS_KERNEL_PRIORITY, never delayed by the OS
 	IntMasterEnable();
 	}
 
@@ -0,0 +1,279 @@
+//*****************************************************************************
+//
+// Filename: kernel_bench.c
+// Description: Microbenchmarks of the kernel primitives.  Each one takes
+// BENCH_SAMPLES samples and prints one line with the minimum, median,
+// 99th percentile and maximum:
+//
+//   bench=switch unit=cycles n=500 min=.. median=.. p99=.. max=..
+//
+// switch    one OS_Suspend from one thread to another at the same priority
+// wake      OS_Signal until the higher priority thread it wakes is running
+// fifo      OS_Fifo_Put followed by OS_Fifo_Get of the same entry
+// addthread one OS_AddThread
+// periodic  release time of a periodic thread until its task starts
+//
+// The lines are meant to be kept and compared between commits.  A final
+// line "bench=done" marks the end of a run.
+//
+// On the board the times are in core clock cycles from the DWT cycle
+// counter, and the results come out of UART0.  Build it in the uart_echo
+// project in place of Lab7.c.  On the host port the times are in
+// nanoseconds from CLOCK_MONOTONIC and go to stdout.  Build and run from
+// boards/ek-lm3s8962:
+//
+//   gcc -O2 -DHOST_PORT -Ihost -I. -I../.. -o kernel_bench bench/kernel_bench.c
+//       host/OS_host.c host/board_host.c drivers/OS.c drivers/OS_sched.c
+//       drivers/OS_stack.c drivers/OS_periodic.c drivers/OS_trace.c
+//       drivers/OS_defer.c
+//   ./kernel_bench
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "inc/hw_memmap.h"
+#include "drivers/OS.h"
+#include "drivers/OS_periodic.h"
+#include "drivers/OSuart.h"
+#include "drivers/cyclecount.h"
+#ifdef HOST_PORT
+#include "host/OS_host.h"
+#endif
+
+#define BENCH_SAMPLES 500
+#define BENCH_PRIORITY 2        // the bench thread and its partners
+#define BENCH_RUN_MS 2000       // host port run time, the bench takes ~1 s
+
+// OS_Time counts 20 ns cycles, which are core cycles on the board
+#ifdef HOST_PORT
+#define BENCH_UNIT "ns"
+#define OS_TIME_TO_BENCH(t) ((t)*CLOCK_PERIOD)
+#else
+#define BENCH_UNIT "cycles"
+#define OS_TIME_TO_BENCH(t) (t)
+#endif
+
+unsigned long NumCreated;   // number of foreground threads created
+
+long Samples[BENCH_SAMPLES];
+int volatile NumBench;                 // samples taken in the current bench
+unsigned long volatile BenchStart;     // Cycle_Count when the timed step began
+int PeriodicId;
+unsigned char volatile BenchDone;
+Sema4Type BenchSema;
+
+extern PeriodicTaskType PeriodicTasks[MAX_PERIODIC_THREADS];
+
+//***********************************************************************
+//
+// CompareSamples orders samples for qsort.
+//
+//***********************************************************************
+static int
+CompareSamples(const void * a, const void * b)
+{
+  long x = *(const long *)a;
+  long y = *(const long *)b;
+
+  return (x > y) - (x < y);
+}
+
+//***********************************************************************
+//
+// Report sorts the samples of one bench, prints its line and starts the
+// next bench.
+//
+//***********************************************************************
+static void
+Report(const char * name)
+{
+  char string[128];
+  int n = NumBench;
+
+  if(n == 0)
+  {
+    sprintf(string, "bench=%s unit=%s n=0\n\r", name, BENCH_UNIT);
+  }
+  else
+  {
+    qsort(Samples, n, sizeof(Samples[0]), &CompareSamples);
+    sprintf(string, "bench=%s unit=%s n=%d min=%ld median=%ld p99=%ld max=%ld\n\r",
+            name, BENCH_UNIT, n, Samples[0], Samples[n/2], Samples[(n*99)/100],
+            Samples[n-1]);
+  }
+  OSuart_OutString(UART0_BASE, string);
+  NumBench = 0;
+}
+
+//***********************************************************************
+//
+// SwitchOnce hands the processor to the other thread at BENCH_PRIORITY
+// and, when it comes back, records how long the other thread's switch
+// back took.
+//
+//***********************************************************************
+static void
+SwitchOnce(void)
+{
+  unsigned long now;
+
+  BenchStart = Cycle_Count();
+  OS_Suspend();
+  now = Cycle_Count();
+  if(NumBench < BENCH_SAMPLES)
+  {
+    Samples[NumBench++] = (long)(now - BenchStart);
+  }
+}
+
+static void
+SwitchPartner(void)
+{
+  while(NumBench < BENCH_SAMPLES)
+  {
+    SwitchOnce();
+  }
+  OS_Kill();
+}
+
+//***********************************************************************
+//
+// Waiter runs above the bench thread, so each OS_Signal switches to it.
+//
+//***********************************************************************
+static void
+Waiter(void)
+{
+  unsigned long now;
+
+  while(NumBench < BENCH_SAMPLES)
+  {
+    OS_Wait(&BenchSema);
+    now = Cycle_Count();
+    Samples[NumBench++] = (long)(now - BenchStart);
+  }
+  OS_Kill();
+}
+
+static void
+Dummy(void)
+{
+  OS_Kill();
+}
+
+//***********************************************************************
+//
+// PeriodicTask compares its start with the release time still in its
+// entry, the timer service moves the release after the task returns.
+//
+//***********************************************************************
+static void
+PeriodicTask(void)
+{
+  long late = OS_TimeDifference(OS_Time(), PeriodicTasks[PeriodicId-1].deadline);
+
+  if(NumBench < BENCH_SAMPLES)
+  {
+    Samples[NumBench++] = OS_TIME_TO_BENCH(late);
+  }
+}
+
+//***********************************************************************
+//
+// Bench runs every benchmark in turn at BENCH_PRIORITY.
+//
+//***********************************************************************
+static void
+Bench(void)
+{
+  int i;
+  unsigned long start, data;
+
+  Cycle_Init();
+
+  // Context switch, each thread records the switches back to it
+  NumBench = 0;
+  OS_AddThread(&SwitchPartner, 128, BENCH_PRIORITY);
+  while(NumBench < BENCH_SAMPLES)
+  {
+    SwitchOnce();
+  }
+  Report("switch");
+
+  // Signal to wake, the waiter records every sample
+  OS_InitSemaphore(&BenchSema, 0);
+  OS_AddThread(&Waiter, 128, BENCH_PRIORITY-1);
+  while(NumBench < BENCH_SAMPLES)
+  {
+    BenchStart = Cycle_Count();
+    OS_Signal(&BenchSema);
+  }
+  Report("wake");
+
+  // FIFO put and get without blocking
+  OS_Fifo_Init(MAX_OS_FIFOSIZE);
+  for(i = 0; i < BENCH_SAMPLES; i++)
+  {
+    start = Cycle_Count();
+    OS_Fifo_Put(i);
+    OS_Fifo_Get(&data);
+    Samples[NumBench++] = (long)(Cycle_Count() - start);
+  }
+  Report("fifo");
+
+  // Thread creation, each dummy runs and kills itself before the next
+  for(i = 0; i < BENCH_SAMPLES; i++)
+  {
+    start = Cycle_Count();
+    if(OS_AddThread(&Dummy, 128, BENCH_PRIORITY) == FAIL)
+    {
+      break;
+    }
+    Samples[NumBench++] = (long)(Cycle_Count() - start);
+    OS_Suspend();
+  }
+  Report("addthread");
+
+  // Periodic thread release at 1 kHz
+  PeriodicId = OS_AddPeriodicThread(&PeriodicTask, TIME_1MS, 0);
+  while(NumBench < BENCH_SAMPLES)
+  {
+    OS_Sleep(10);
+  }
+  Report("periodic");
+
+  OSuart_OutString(UART0_BASE, "bench=done\n\r");
+  BenchDone = 1;
+  OS_Kill();
+}
+
+static void
+Idle(void)
+{
+  for(;;)
+  {
+  }
+}
+
+#ifdef HOST_PORT
+static int
+BenchReport(void)
+{
+  return !BenchDone;
+}
+#endif
+
+int
+main(void)
+{
+  OS_Init();           // initialize, disable interrupts
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&Bench, 512, BENCH_PRIORITY);
+  NumCreated += OS_AddThread(&Idle, 128, NUM_PRIORITIES-1);
+#ifdef HOST_PORT
+  Host_RunFor(BENCH_RUN_MS, &BenchReport);
+#endif
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
@@ -0,0 +1,157 @@
+//*****************************************************************************
+//
+// Filename: sched_bench.c
+// Description: Host benchmark for the thread switch decision.  Compares the
+// old PendSVHandler search (two walks of the circular thread list) against
+// the ready queues in drivers/OS_sched.c for 2, 10 and 64 threads, and
+// prints the average cost of one decision in nanoseconds.
+//
+// This file runs on the development PC, not on the board.  Build and run
+// from boards/ek-lm3s8962:
+//
+//   gcc -O2 -I. -o sched_bench bench/sched_bench.c drivers/OS_sched.c
+//   ./sched_bench
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "drivers/OS.h"
+#include "drivers/OS_sched.h"
+
+#define MAX_BENCH_THREADS 64
+#define DECISIONS 1000000
+#define BENCH_PRIORITIES 4   // threads are spread over this many levels
+
+TCB LegacyThreads[MAX_BENCH_THREADS];
+TCB ReadyThreads[MAX_BENCH_THREADS];
+TCB * volatile Picked;      // keeps the compiler from dropping the loops
+
+//***********************************************************************
+//
+// NowNs returns a monotonic time stamp in nanoseconds.
+//
+//***********************************************************************
+static double
+NowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+//***********************************************************************
+//
+// LegacyPickNext is the search PendSVHandler did before the ready queues:
+// one pass over the whole list for the run priority and sleep counters,
+// then a second pass for the next eligible thread.
+//
+//***********************************************************************
+static TCB *
+LegacyPickNext(TCB * ThreadList, TCB * CurrentThread)
+{
+  TCB * TempPt;
+  TCB * NextThread;
+  unsigned long RunPriorityLevel = 100;
+
+  TempPt = ThreadList;
+  do
+  {
+    if((TempPt->BlockPt == NULL)&&(TempPt->priority < RunPriorityLevel)&&(TempPt->sleepCount == 0))
+    {
+      RunPriorityLevel = TempPt->priority;
+    }
+    if(TempPt->sleepCount > 0)
+    {
+      (TempPt->sleepCount)--;
+    }
+    TempPt = TempPt->next;
+  }while(TempPt != ThreadList);
+
+  NextThread = CurrentThread;
+  do
+  {
+    NextThread = NextThread->next;
+  }while(((NextThread->sleepCount != 0)||(NextThread->BlockPt != NULL)||(NextThread->priority > RunPriorityLevel))&&(NextThread!=CurrentThread));
+
+  return NextThread;
+}
+
+//***********************************************************************
+//
+// BenchLegacy times LegacyPickNext with numThreads threads in the list.
+// The highest priority level is put at the end of the list, which is
+// the usual case when the foreground threads are added last.
+//
+//***********************************************************************
+static double
+BenchLegacy(int numThreads)
+{
+  int i;
+  double start;
+  TCB * current;
+
+  for(i = 0; i < numThreads; i++)
+  {
+    LegacyThreads[i].priority = BENCH_PRIORITIES-1 - (i*BENCH_PRIORITIES)/numThreads;
+    LegacyThreads[i].sleepCount = 0;
+    LegacyThreads[i].BlockPt = NULL;
+    LegacyThreads[i].next = &LegacyThreads[(i+1)%numThreads];
+  }
+  current = &LegacyThreads[0];
+
+  start = NowNs();
+  for(i = 0; i < DECISIONS; i++)
+  {
+    current = LegacyPickNext(&LegacyThreads[0], current);
+  }
+  Picked = current;
+  return (NowNs() - start)/DECISIONS;
+}
+
+//***********************************************************************
+//
+// BenchReady times Sched_PickNext with the same thread set.
+//
+//***********************************************************************
+static double
+BenchReady(int numThreads)
+{
+  int i;
+  double start;
+  TCB * current = NULL;
+
+  Sched_Init();
+  for(i = 0; i < numThreads; i++)
+  {
+    ReadyThreads[i].priority = BENCH_PRIORITIES-1 - (i*BENCH_PRIORITIES)/numThreads;
+    ReadyThreads[i].sleepCount = 0;
+    ReadyThreads[i].BlockPt = NULL;
+    Sched_ReadyInsert(&ReadyThreads[i]);
+  }
+
+  start = NowNs();
+  for(i = 0; i < DECISIONS; i++)
+  {
+    current = Sched_PickNext(current);
+  }
+  Picked = current;
+  return (NowNs() - start)/DECISIONS;
+}
+
+int
+main(void)
+{
+  static const int threadCounts[] = {2, 10, 64};
+  int i;
+
+  printf("threads  list walk (ns)  ready bitmap (ns)\n");
+  for(i = 0; i < (int)(sizeof(threadCounts)/sizeof(threadCounts[0])); i++)
+  {
+    double legacy = BenchLegacy(threadCounts[i]);
+    double ready = BenchReady(threadCounts[i]);
+    printf("%7d  %14.2f  %17.2f\n", threadCounts[i], legacy, ready);
+  }
+  return 0;
+}
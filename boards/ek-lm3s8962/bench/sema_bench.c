@@ -0,0 +1,210 @@
+//*****************************************************************************
+//
+// Filename: sema_bench.c
+// Description: Host benchmark for semaphore contention.  Many consumer
+// threads block on one semaphore and producers signal it until all of them
+// have run again.  The old OS_Signal scan of every thread is compared with
+// the priority ordered wait queue in drivers/OS_sched.c.  The average cost
+// of one wait plus one signal is printed in nanoseconds.
+//
+// Only the kernel bookkeeping is timed, there is no real thread switch.
+// This file runs on the development PC, not on the board.  Build and run
+// from boards/ek-lm3s8962:
+//
+//   gcc -O2 -I. -o sema_bench bench/sema_bench.c drivers/OS_sched.c
+//   ./sema_bench
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include <time.h>
+#include "drivers/OS.h"
+#include "drivers/OS_sched.h"
+
+#define MAX_BENCH_THREADS 64
+#define ROUNDS 20000
+#define BENCH_PRIORITIES 8   // waiters are spread over this many levels
+
+TCB LegacyThreads[MAX_BENCH_THREADS];
+TCB QueueThreads[MAX_BENCH_THREADS];
+Sema4Type LegacySema;
+Sema4Type QueueSema;
+unsigned long volatile Woken;   // keeps the compiler from dropping the loops
+
+//***********************************************************************
+//
+// NowNs returns a monotonic time stamp in nanoseconds.
+//
+//***********************************************************************
+static double
+NowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+//***********************************************************************
+//
+// LegacyWait and LegacySignal are the semaphore operations before the
+// wait queues: a blocked thread stays in the thread list and a signal
+// scans the whole list for the highest priority thread blocked on the
+// semaphore.
+//
+//***********************************************************************
+static void
+LegacyWait(Sema4Type *semaPt, TCB * thread)
+{
+  (semaPt->value)--;
+  if((semaPt->value) < 0)
+  {
+    thread->BlockPt = semaPt;
+  }
+}
+
+static TCB *
+LegacySignal(Sema4Type *semaPt, TCB * ThreadList)
+{
+  TCB * temp = ThreadList;
+  TCB * toUnblock = NULL;
+  unsigned long highest_priority = 100;
+
+  (semaPt->value)++;
+  if((semaPt->value) <= 0)
+  {
+    do
+    {
+      if(((temp->BlockPt) == semaPt) && (temp->priority < highest_priority))
+      {
+        toUnblock = temp;
+        highest_priority = toUnblock->priority;
+      }
+      temp = temp->next;
+    }
+    while(temp != ThreadList);
+    if(toUnblock != NULL)
+    {
+      toUnblock->BlockPt = NULL;
+    }
+  }
+  return toUnblock;
+}
+
+//***********************************************************************
+//
+// QueueWait and QueueSignal do the same bookkeeping as OS_Wait and
+// OS_Signal in drivers/OS.c.
+//
+//***********************************************************************
+static void
+QueueWait(Sema4Type *semaPt, TCB * thread)
+{
+  (semaPt->value)--;
+  if((semaPt->value) < 0)
+  {
+    thread->BlockPt = semaPt;
+    Sched_ReadyRemove(thread);
+    Sched_WaitInsert(&(semaPt->waitList), thread);
+  }
+}
+
+static TCB *
+QueueSignal(Sema4Type *semaPt)
+{
+  TCB * toUnblock = NULL;
+
+  (semaPt->value)++;
+  if((semaPt->value) <= 0)
+  {
+    toUnblock = Sched_WaitPop(&(semaPt->waitList));
+    if(toUnblock != NULL)
+    {
+      toUnblock->BlockPt = NULL;
+      Sched_ReadyInsert(toUnblock);
+    }
+  }
+  return toUnblock;
+}
+
+//***********************************************************************
+//
+// Each round every consumer waits on the empty semaphore, then the
+// producers signal once per consumer.  The waiters arrive in rising
+// priority order, which is the worst case for the wait queue insert.
+//
+//***********************************************************************
+static double
+BenchLegacy(int numThreads)
+{
+  int i, round;
+  double start;
+
+  for(i = 0; i < numThreads; i++)
+  {
+    LegacyThreads[i].priority = BENCH_PRIORITIES-1 - (i*BENCH_PRIORITIES)/numThreads;
+    LegacyThreads[i].BlockPt = NULL;
+    LegacyThreads[i].next = &LegacyThreads[(i+1)%numThreads];
+  }
+  LegacySema.value = 0;
+
+  start = NowNs();
+  for(round = 0; round < ROUNDS; round++)
+  {
+    for(i = 0; i < numThreads; i++)
+    {
+      LegacyWait(&LegacySema, &LegacyThreads[i]);
+    }
+    for(i = 0; i < numThreads; i++)
+    {
+      Woken += LegacySignal(&LegacySema, &LegacyThreads[0])->priority;
+    }
+  }
+  return (NowNs() - start)/((double)ROUNDS*numThreads);
+}
+
+static double
+BenchQueue(int numThreads)
+{
+  int i, round;
+  double start;
+
+  Sched_Init();
+  for(i = 0; i < numThreads; i++)
+  {
+    QueueThreads[i].priority = BENCH_PRIORITIES-1 - (i*BENCH_PRIORITIES)/numThreads;
+    QueueThreads[i].BlockPt = NULL;
+    Sched_ReadyInsert(&QueueThreads[i]);
+  }
+  QueueSema.value = 0;
+  QueueSema.waitList = NULL;
+
+  start = NowNs();
+  for(round = 0; round < ROUNDS; round++)
+  {
+    for(i = 0; i < numThreads; i++)
+    {
+      QueueWait(&QueueSema, &QueueThreads[i]);
+    }
+    for(i = 0; i < numThreads; i++)
+    {
+      Woken += QueueSignal(&QueueSema)->priority;
+    }
+  }
+  return (NowNs() - start)/((double)ROUNDS*numThreads);
+}
+
+int
+main(void)
+{
+  static const int threadCounts[] = {2, 10, 64};
+  int i;
+
+  printf("threads  thread scan (ns)  wait queue (ns)\n");
+  for(i = 0; i < (int)(sizeof(threadCounts)/sizeof(threadCounts[0])); i++)
+  {
+    double legacy = BenchLegacy(threadCounts[i]);
+    double queue = BenchQueue(threadCounts[i]);
+    printf("%7d  %16.2f  %15.2f\n", threadCounts[i], legacy, queue);
+  }
+  return 0;
+}
@@ -491,7 +491,7 @@ unsigned char SpeedLastL;
 int main(void)
 {
 	int i;
-	Ping_Init(TIMER2_BASE, TIMER_A); 
+	Ping_Init(1); 
 	Tach_Init(0);
 	Motor_Init();
 	Motor_Configure(0, 0, 10000, 3000); 
@@ -13,10 +13,11 @@
 // Modules used:
 //		1. GPTimers:
 //			a. GPTimer3 is used for periodic tasks (see OS_AddPeriodicThread)
-//			b. GPTimer1 is like a general TCNT
+//			b. GPTimer2 is the system timebase (see drivers/timebase.c)
 //			c. GPTimer0 is used for ADC triggering (see ADC_Collect)
-//      2. SysTick: The period of the SysTick is used to dictate the TIMESLICE
-//		   for thread switching.  Systick handler causes thread switch.
+//      2. SysTick: SysTick is the 1 ms OS tick that wakes sleeping threads
+//		   (or the TIMESLICE if it is shorter than 1 ms).  Systick handler
+//		   causes a thread switch every TIMESLICE.
 //		3. ADC: all 4 channels may be accessed.
 //		4. UART: UART0 is used for communication with a console.
 //
@@ -35,6 +36,12 @@
 #include "driverlib/fifo.h"
 #include "driverlib/adc.h"
 #include "drivers/OS.h"
+#include "drivers/OS_sched.h"
+#include "drivers/OS_stack.h"
+#include "drivers/OS_periodic.h"
+#include "drivers/OS_defer.h"
+#include "drivers/OS_trace.h"
+#include "drivers/timebase.h"
 #include "drivers/rit128x96x4.h"
 #include "string.h"
 #include "driverlib/can.h"
@@ -46,8 +53,6 @@
 //***********************************************************************
 #define NVIC_PRI11_REG (*((volatile unsigned long *)(0xE000E42C)))	//#46 GPIOF	  Reg:(44-47)
 #define NVIC_PRI12_REG (*((volatile unsigned long *)(0xE000E430)))  //#51 Timer3A Reg:(48-51)
-#define OS_ENTERCRITICAL(){sr = SRSave();}
-#define OS_EXITCRITICAL(){SRRestore(sr);}
 #define CAN_FIFO_SIZE           (8 * 5)
 //***********************************************************************
 // 
@@ -55,38 +60,51 @@
 //
 //***********************************************************************
 
+unsigned long RunningCount;
+unsigned long const OSBasePri = OS_BASEPRI;   // read by SRSave in OS_asm.s
+
 //***********************************************************************
-// For Periodic Tasks
+// For Time Profiling
 //***********************************************************************
-void(*PeriodicTaskA)(void);
-void(*PeriodicTaskB)(void);
-unsigned char TimerAFree;
-unsigned char TimerBFree;
-Sema4Type PeriodicTimerMutex;
+unsigned long TimeIbitDisabled;     // longest critical section in clock cycles
+CritSiteType * CritMaxSite;         // where it was
+CritSiteType CritSites[CRIT_SITES];
+unsigned char CritNumSites;
+unsigned long CritHistogram[CRIT_BUCKETS];  // bucket b counts sections under 2^b usec
 
-unsigned long RunningCount;
+//***********************************************************************
+// For CPU Accounting
+//***********************************************************************
+unsigned long long IsrRunTime[NUM_ISR_CLASSES];  // clock cycles spent in each ISR class
+unsigned long IsrCycles;          // clock cycles spent in all ISRs, wraps
+unsigned long IsrCyclesAtSwitch;  // IsrCycles when CurrentThread was switched in
+unsigned long SwitchTime;         // OS_Time when CurrentThread was switched in
+
+//***********************************************************************
+// For CPU Load
+//***********************************************************************
+TCB * IdleThread;                   // runs when no other thread is ready
+unsigned long long IdleTimeAtSecond;    // idle clock cycles at the last whole second
+unsigned long IdleSeconds[LOAD_WINDOW]; // idle clock cycles in each of the last seconds
+unsigned long IdleSecond;           // next entry of IdleSeconds
+unsigned long LoadSeconds;          // entries of IdleSeconds filled in
+unsigned long LoadCount;            // ms left until the next whole second
+unsigned long CpuLoad1s;            // CPU load over the last second, in 0.1%
+unsigned long CpuLoad10s;           // over the last LOAD_WINDOW seconds, in 0.1%
 
-unsigned long const JitterSize=JITTERSIZE;
-unsigned long JitterHistogramA[JITTERSIZE]={0,};
-unsigned long JitterHistogramB[JITTERSIZE]={0,};
-long MaxJitterA;             // largest time jitter between interrupts in usec
-long MinJitterA;             // smallest time jitter between interrupts in usec
-long MaxJitterB;             // largest time jitter between interrupts in usec
-long MinJitterB;             // smallest time jitter between interrupts in usec
-long PeriodTimerA;
-long PeriodTimerB;
-unsigned char firstJitterA;
-unsigned char firstJitterB;
-extern unsigned long NumSamples;
+//***********************************************************************
+// For Priority Inheritance
+//***********************************************************************
+unsigned long MutexInversions;      // inversions bounded by OS_MutexLock
+unsigned long MutexInversionMax;    // longest inversion in usec
+unsigned long MutexInversionTotal;  // total inversion time in usec
 
 //***********************************************************************
-// For Time Profiling
+// For Wake-to-Run Latency
 //***********************************************************************
-unsigned long CumulativeRunTime;
-unsigned long TimeIbitDisabled;
-unsigned long RunTimeProfile[NUM_EVENTS][2]; //Collect data for 100 events   RunTimeProfile[Time(ms)][0x04] -> Periodic Thread Start (based on OS.h)
-int EventIndex;
-unsigned long CumLastTime;  // time at previous interrupt 
+unsigned long WakeLatencyCount;     // woken threads that have run
+unsigned long WakeLatencyMax;       // longest latency in 0.1 usec
+unsigned long WakeLatencyTotal;     // total latency in 0.1 usec
 
 extern struct
 {
@@ -183,25 +201,25 @@ void(*RightTask)(void) = NULL;
 //***********************************************************************
 TCB * CurrentThread;     //pointer to the current thread
 TCB * NextThread;		 //pointer to the next thread to run
-TCB * Sleeper;			 //pointer to a sleeping thread
-TCB * ThreadList;		 //pointer to the beginning of the circular linked list of TCBs
+unsigned long TickPeriod;  //SysTick period in clock cycles
+unsigned long TickAccum;   //clock cycles not yet counted as a whole ms
+unsigned long SliceTicks;  //number of SysTick interrupts per timeslice
+unsigned long SliceCount;  //SysTick interrupts left in this timeslice
 struct tcb OSThreads[MAX_NUM_OS_THREADS];  //pointers to all the threads in the OS
-unsigned char ThreadStacks[MAX_NUM_OS_THREADS][STACK_SIZE];
+unsigned char * DeadStack;  //stack of a killed thread, still running on it
+unsigned char * LeftStack;  //stack of a killed thread the last switch left, freed on the next
 
 //***********************************************************************
 // Miscellaneous
 //***********************************************************************
-unsigned long MailBox1;
-Sema4Type fifoDataReady;
+FifoType MailBox;               // one entry, see OS_MailBox_Send
+unsigned long MailBoxData;
 
 //***********************************************************************
-// OS_Fifo variables, this code segment copied from Valvano, lecture1
+// The FIFO behind OS_Fifo_Init, OS_Fifo_Put and OS_Fifo_Get
 //***********************************************************************
-typedef unsigned long dataType;
-dataType volatile *PutPt; // put next
-dataType volatile *GetPt; // get next
-dataType static Fifo[MAX_OS_FIFOSIZE];
-unsigned long FifoSize;
+unsigned long OSFifoBuffer[MAX_OS_FIFOSIZE];
+FifoType OSFifo;
 
 //***********************************************************************
 //
@@ -210,12 +228,18 @@ unsigned long FifoSize;
 //***********************************************************************
 int PerThreadSwitchInit(unsigned long period);
 unsigned char * StackInit(unsigned char * ThreadStkPtr, void(*task)(void));
-void SwitchThreads(void);
 void LaunchInternal(unsigned char * firstStackPtr);
 void TriggerPendSV(void);
 long SRSave (void);
 void SRRestore(long sr);
+void WakeThread(TCB * thread);
+void WaitForInterrupt(void);
 extern void OSuart_Open(void);
+static TCB * NewThread(void(*task)(void), unsigned long stackSize, unsigned long priority);
+static int MutexLock(MutexType *mutexPt, unsigned long timeout, int forever);
+static unsigned long InheritedPriority(TCB * thread);
+static void IdleInit(void);
+static unsigned long FifoTakeN(FifoType *fifoPt, unsigned long data[], unsigned long max);
 
 //***********************************************************************
 //
@@ -234,17 +258,8 @@ OS_Init(void)
   // Set the clocking to run from PLL at 50 MHz 
   SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_8MHZ);
   
-  //Initialize a TCNT-like countdown timer on timer 1
- 
-  // Enable Timer1 module
-  SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER1);
-
-  // Configure Timer1 as a 32-bit periodic timer.
-  TimerConfigure(TIMER1_BASE, TIMER_CFG_32_BIT_PER);
-  TimerLoadSet(TIMER1_BASE, TIMER_A, MAX_TCNT);
-
-  // Start Timer1.
-  TimerEnable(TIMER1_BASE, TIMER_A);
+  // Start the timebase that OS_Time reads
+  Timebase_Init();
 
   // For profiling the time interrupts are disabled.
   TimeIbitDisabled = 0;
@@ -255,7 +270,10 @@ OS_Init(void)
     OSThreads[threadNum].id = DEAD;  
   }
   CurrentThread = NULL;	
-  ThreadList = NULL;
+  Sched_Init();
+  Stack_Init();
+  DeadStack = NULL;
+  LeftStack = NULL;
 
   OS_DebugProfileInit();
   // Initialize oLED display
@@ -266,49 +284,113 @@ OS_Init(void)
   OSuart_Open();
 
   // For periodic threads
-  OS_InitSemaphore(&PeriodicTimerMutex, 1);
-  TimerAFree = 1;
-  TimerBFree = 1;
-  firstJitterA = 1;
-  firstJitterB = 1;
+  Periodic_Init();
 
   //For profiling
   TimeIbitDisabled = 0;
-  EventIndex = 0;
-  CumulativeRunTime = 0;
-  EventIndex = 0;
-  CumLastTime = 0;
+  CritMaxSite = NULL;
 
   RunningCount = 0;
 
+  MutexInversions = 0;
+  MutexInversionMax = 0;
+  MutexInversionTotal = 0;
+
+  WakeLatencyCount = 0;
+  WakeLatencyMax = 0;
+  WakeLatencyTotal = 0;
+
+  // The thread that runs work deferred by ISRs
+  Defer_Init();
+
+  // The thread that runs when no other thread is ready
+  IdleInit();
 } 
 
 
 //***********************************************************************
 //
 // OS_AddThread	initializes a TCB in the global TCB array and places the
-// new TCB at the end of a circular linked list.
+// new TCB at the end of the ready list for its priority.
 //
 // \param task is the program associated with the thread
-// \param stackSize is the size of the thread's stack in bytes
-// \param id is a numerical identifier for the TCB
+// \param stackSize is the size of the thread's stack in bytes, taken 
+// from the stack arena and rounded up to 8 bytes.  Interrupts run on
+// their own stack, so it only needs room for the thread, plus 64 bytes
+// of registers saved when the thread is interrupted and switched out.
+// Less than STACK_MIN_SIZE fails.
+// \param priority is the thread priority, OS_USER_PRIORITY (the highest)
+// to NUM_PRIORITIES-1.  Priority 0 is kept for the deferred work thread,
+// so no user thread can hold up work deferred by ISRs.
 //
-// \return SUCCESS if there was room for the thread, FAIL otherwise.
+// \return SUCCESS if there was room for the thread and its stack, FAIL
+// otherwise or if \param priority is out of range.
 //
 //***********************************************************************
 int
 OS_AddThread(void(*task)(void), unsigned long stackSize, unsigned long priority)
 {
-  int threadNum;
-  int addNum = 0;
-  TCB * searchPtr;
-  int addSuccess = FAIL;
+  if(priority < OS_USER_PRIORITY)
+  {
+    return FAIL;
+  }
+  return OS_AddKernelThread(task, stackSize, priority);
+}
+
+//***********************************************************************
+//
+// OS_AddKernelThread adds a thread like OS_AddThread, at any priority
+// including the ones below OS_USER_PRIORITY.  Only for the kernel's own
+// threads.
+//
+//***********************************************************************
+int
+OS_AddKernelThread(void(*task)(void), unsigned long stackSize, unsigned long priority)
+{
+  TCB * thread;
 
   //Enter critical
   long sr = 0;
   unsigned long timeIoff;
+
+  if(priority >= NUM_PRIORITIES)
+  {
+    return FAIL;
+  }
   OS_ENTERCRITICAL();
-  
+
+  thread = NewThread(task, stackSize, priority);
+  if(thread != NULL)
+  {
+    //
+    // Make the new thread ready to run
+    //
+	Sched_ReadyInsert(thread);
+  }
+
+  //Exit critical
+  OS_EXITCRITICAL();
+
+  return (thread != NULL) ? SUCCESS : FAIL;
+}
+
+//***********************************************************************
+//
+// NewThread initializes a TCB in the global TCB array with a stack from
+// the arena, but does not make it ready.  Must be called in a critical
+// section.
+//
+// \return the TCB, NULL if there was no room for the thread or its stack.
+//
+//***********************************************************************
+static TCB *
+NewThread(void(*task)(void), unsigned long stackSize, unsigned long priority)
+{
+  int threadNum;
+  int addNum = 0;
+  int addSuccess = FAIL;
+  unsigned char * stack = NULL;
+
   //
   // Look for the lowest avaliable slot in the OSThread list, if there is no spot,
   // return with error code.  If there is a spot, initialize it with the given
@@ -323,13 +405,23 @@ OS_AddThread(void(*task)(void), unsigned long stackSize, unsigned long priority)
     }
   }
 
+  if(addSuccess == SUCCESS)
+  {
+    stack = Stack_Alloc(stackSize);
+    if(stack == NULL)
+    {
+      addSuccess = FAIL;
+    }
+  }
+
   if(addSuccess == SUCCESS)
   {
     //
     // Initialize the stack pointer for the TCB with the bottom of the 
-    // stack.
+    // stack.  StackInit throws away one word before it starts pushing.
     //
-    OSThreads[addNum].stackPtr = &ThreadStacks[addNum][STACK_SIZE-1];
+    OSThreads[addNum].stackBase = stack;
+    OSThreads[addNum].stackPtr = stack + Stack_Size(stack) - sizeof(unsigned long);
     //
     // Load initial values onto the stack
     //
@@ -337,48 +429,65 @@ OS_AddThread(void(*task)(void), unsigned long stackSize, unsigned long priority)
 
 	OSThreads[addNum].id = addNum+1;
 	OSThreads[addNum].priority = priority;
+	OSThreads[addNum].basePriority = priority;
 	OSThreads[addNum].sleepCount = 0;
+	OSThreads[addNum].sleepNext = NULL;
+	OSThreads[addNum].sleepPrev = NULL;
+	OSThreads[addNum].timedWait = 0;
+	OSThreads[addNum].timedOut = 0;
+	OSThreads[addNum].waitList = NULL;
 	OSThreads[addNum].BlockPt = NULL;
+	OSThreads[addNum].MutexBlockPt = NULL;
+	OSThreads[addNum].MutexList = NULL;
+	OSThreads[addNum].flagsWait = 0;
+	OSThreads[addNum].flagsMode = 0;
+	OSThreads[addNum].wakePending = 0;
+	OSThreads[addNum].runTime = 0;
+	OSThreads[addNum].switches = 0;
+	OSThreads[addNum].overruns = 0;
   }	   
-  
-  //
-  // Add the new thread to the circular linked list of threads
-  //
-  if(ThreadList == NULL) // List is empty, this is the first thread
-  {
-    // Current thread is the start of the list
-	ThreadList = &OSThreads[addNum];
-	
-	// Thread points back to the beginning of the list  
-	OSThreads[addNum].next = ThreadList; 
-
-  }
-  else
-  {
-    searchPtr = (*ThreadList).next;
-
-	// Sets searchPtr to the end element on the list
-	// Find where the list wraps around  
-	while((*searchPtr).next != ThreadList)
-	{
-	  searchPtr = (*searchPtr).next;
-	}
-
-	// Add the new TCB to the end of the list
-	searchPtr->next = &OSThreads[addNum];
 
-	// Advance to the current element
-	searchPtr = (*searchPtr).next;
+  return (addSuccess == SUCCESS) ? &OSThreads[addNum] : NULL;
+}
 
-	// Set the next pointer of the new TCB to the beginning of the list
-	(*searchPtr).next = ThreadList; 
+//***********************************************************************
+//
+// IdleTask is the idle thread.  It sleeps the core until the next
+// interrupt, its run time is the idle time behind the CPU load.
+//
+//***********************************************************************
+static void
+IdleTask(void)
+{
+  for(;;)
+  {
+    WaitForInterrupt();
   }
+}
 
-  //Exit critical
+//***********************************************************************
+//
+// IdleInit creates the idle thread.  It is on no ready list, the
+// scheduler runs it when every ready list is empty, and its priority is
+// below all of them so any thread that wakes up preempts it.
+//
+//***********************************************************************
+static void
+IdleInit(void)
+{
+  long sr = 0;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  IdleThread = NewThread(&IdleTask, IDLE_STACK_SIZE, IDLE_PRIORITY);
+  IdleThread->state = THREAD_READY;
   OS_EXITCRITICAL();
 
-  return addSuccess;
-
+  IdleTimeAtSecond = 0;
+  IdleSecond = 0;
+  LoadSeconds = 0;
+  LoadCount = 1000;
+  CpuLoad1s = 0;
+  CpuLoad10s = 0;
 }
 
 //***********************************************************************
@@ -534,105 +643,7 @@ OS_RemoveButtonTask(void(*task)(void))
 
 //***********************************************************************
 //
-// OS_AddPeriodicThread 
-//
-// \param task is a pointer to the function to be executed at a periodic rate
-// \param period is the period to be loaded to timer register
-// \param priority is the priority of the task to be used in the NVIC
-//
-// \return the numerical ID for the periodic thread. Error code FAIL returned
-// if \param priority is out of acceptable range.
-//
-//***********************************************************************
-int 
-OS_AddPeriodicThread(void(*task)(void), unsigned long period, unsigned long priority)
-{
-  //Enter critical 
-  long sr = 0;
-  unsigned long timeIoff;
-  OS_ENTERCRITICAL();
-
-  //Initialization for Jitter calculation:
-  MaxJitterA = 0;       // OS_Time in 20ns units
-  MinJitterA = 10000000;
-  MaxJitterB = 0;       // OS_Time in 20ns units
-  MinJitterB = 10000000;
-
-  //Check for timer availiability
-  OS_bWait(&PeriodicTimerMutex);
-  if(TimerAFree){
-    TimerAFree = 0;  //False
-  	OS_bSignal(&PeriodicTimerMutex);
-  	PeriodicTaskA = task;
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER3);
-	  TimerDisable(TIMER3_BASE, TIMER_A);
-    // Set the global timer configuration.
-    HWREG(TIMER3_BASE + 0x00000000) = (TIMER_CFG_16_BIT_PAIR|TIMER_CFG_A_PERIODIC) >> 24;
-    // Set the configuration of the A and B timers.  Note that the B timer
-    // configuration is ignored by the hardware in 32-bit modes.
-    HWREG(TIMER3_BASE + 0x00000004) = (TIMER_CFG_16_BIT_PAIR|TIMER_CFG_A_PERIODIC) & 255;
-    
-	TimerPrescaleSet(TIMER3_BASE, TIMER_A, 45);
-	
-	TimerLoadSet(TIMER3_BASE, TIMER_A, period);
-	  PeriodTimerA = (long)period;
-    TimerIntEnable(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
-    TimerIntClear(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
-    IntEnable(INT_TIMER3A);                                                                                
-    if(priority < 8){
-      IntPrioritySet(INT_TIMER3A,(((unsigned char)priority)<<5)&0xF0);
-    }
-    else{
-//      IntMasterEnable();
-	   OS_EXITCRITICAL();
-	   return FAIL; 
-    }
-    TimerEnable(TIMER3_BASE, TIMER_A);
-	//Exit critical 
-//    IntMasterEnable();
-    OS_EXITCRITICAL();
-	return SUCCESS;
-  }
-  else if(TimerBFree){
-    TimerBFree = 0;  //False
-	OS_bSignal(&PeriodicTimerMutex);
-	PeriodicTaskB = task;
-	TimerDisable(TIMER3_BASE, TIMER_B);
-    // Set the global timer configuration.
-    HWREG(TIMER3_BASE + 0x00000000) = (TIMER_CFG_16_BIT_PAIR|TIMER_CFG_B_PERIODIC) >> 24;
-    // Set the configuration of the A and B timers.  Note that the B timer
-    // configuration is ignored by the hardware in 32-bit modes.
-    HWREG(TIMER3_BASE + 0x00000008) = ((TIMER_CFG_16_BIT_PAIR|TIMER_CFG_B_PERIODIC)>> 8) & 255;
-    TimerLoadSet(TIMER3_BASE, TIMER_B, period);
-	PeriodTimerB = (long)period;
-    TimerIntEnable(TIMER3_BASE, TIMER_TIMB_TIMEOUT);
-    TimerIntClear(TIMER3_BASE, TIMER_TIMB_TIMEOUT);
-    IntEnable(INT_TIMER3B);                                                                                
-    if(priority < 8){
-      IntPrioritySet(INT_TIMER3B,(((unsigned char)priority)<<5)&0xF0);
-    }
-    else{
-//       IntMasterEnable();
-      OS_EXITCRITICAL();
-	  return FAIL; 
-    }
-    TimerEnable(TIMER3_BASE, TIMER_B);
-	//Exit critical 
-//    IntMasterEnable();
-    OS_EXITCRITICAL();
-	return SUCCESS;
-  }
-  
-  OS_bSignal(&PeriodicTimerMutex);
-  //Exit critical 
-  OS_EXITCRITICAL();
-  return FAIL;
-}
-
-//***********************************************************************
-//
-// OS_Launch starts the OS on the first thread in the circular linked list
-// of threads.
+// OS_Launch starts the OS on the highest priority thread.
 //
 // \param period is the timeslice of the OS, the execution time share for 
 // each thread.
@@ -643,15 +654,23 @@ OS_AddPeriodicThread(void(*task)(void), unsigned long period, unsigned long prio
 void
 OS_Launch(unsigned long period)
 {
-  //The first thread is the one at the beginning of the list
-  CurrentThread = ThreadList;
+  //The first thread is the one at the front of the highest priority list
+  CurrentThread = Sched_PickNext(IdleThread);
+  CurrentThread->switches++;
+  SwitchTime = OS_Time();
+  IsrCyclesAtSwitch = IsrCycles;
   PerThreadSwitchInit(period);
   LaunchInternal(CurrentThread->stackPtr);  //doesn't return  
 }
 
 //***********************************************************************
 //
-// OS_Sleep puts a thread to sleep for a given number of milliseconds
+// OS_Sleep puts a thread to sleep for a given number of milliseconds.
+// The thread wakes up on the sleepCount'th OS tick, independent of how
+// often threads switch.
+//
+// \param sleepCount is the sleep time in ms, 0 just gives up the processor.
+// \return none.
 //
 //***********************************************************************
 void
@@ -660,8 +679,13 @@ OS_Sleep(unsigned long sleepCount)
   long sr = 0;
   unsigned long timeIoff;
   OS_ENTERCRITICAL();
-  // Put the thread to sleep by loading a value into the sleep counter
-  CurrentThread->sleepCount = sleepCount;
+  // Put the thread to sleep by moving it from the ready list to the 
+  // sleep delta queue
+  if(sleepCount > 0)
+  {
+    Sched_ReadyRemove(CurrentThread);
+    Sched_SleepInsert(CurrentThread, sleepCount);
+  }
 
   // Pass control to the next thread
   OS_EXITCRITICAL();
@@ -669,6 +693,64 @@ OS_Sleep(unsigned long sleepCount)
   TriggerPendSV();  
 }
 
+//***********************************************************************
+//
+// OS_SleepUntil puts a thread to sleep until the next release of a
+// periodic loop, period ms after the last one.  Releases are counted
+// from *lastWake rather than from the call, so the loop does not drift
+// by its own execution time.  A release that has already passed is an
+// overrun: the thread does not sleep, releases it missed completely are
+// skipped, and each one counts in the thread's overruns.
+//
+// \param lastWake is the OS_MsTime of the last release, set it to
+// OS_MsTime() before the loop.  It is moved to the next release.
+// \param period is the period in ms.
+// \return none.
+//
+//***********************************************************************
+void
+OS_SleepUntil(unsigned long * lastWake, unsigned long period)
+{
+  unsigned long release = *lastWake + period;
+  unsigned long missed;
+  long wait;
+  long sr = 0;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  wait = (long)(release - RunningCount);
+  if(wait > 0)
+  {
+    Sched_ReadyRemove(CurrentThread);
+    Sched_SleepInsert(CurrentThread, wait);
+  }
+  else if(wait < 0)
+  {
+    // Late, run now and keep the phase of the releases
+    missed = (period > 0) ? (unsigned long)(-wait)/period : 0;
+    CurrentThread->overruns += 1 + missed;
+    release += missed*period;
+  }
+  *lastWake = release;
+  OS_EXITCRITICAL();
+
+  if(wait > 0)
+  {
+    TriggerPendSV();
+  }
+}
+
+//***********************************************************************
+//
+// OS_MsTime returns the OS time in ms, the count of OS ticks since
+// OS_Init.  It wraps every 49.7 days.
+//
+//***********************************************************************
+unsigned long
+OS_MsTime(void)
+{
+  return RunningCount;
+}
+
 //***********************************************************************
 //
 //  OS_Suspend causes control to be passed to the next thread in the 
@@ -686,10 +768,11 @@ OS_Suspend(void)
 
 //***********************************************************************
 //
-// OS_Kill removes the current thread from the linked list.  This 
+// OS_Kill removes the current thread from the ready list.  This 
 // function does not change the CurrentThread pointer so that the
 // current thread can finish and the next thread switch will be
-// correct.
+// correct.  The thread's stack goes back to the arena on the switch
+// after the one that leaves it, which still saves registers on it.
 //
 // \param none.
 // \return none. 
@@ -700,34 +783,15 @@ OS_Kill(void)
 {
   long sr = 0;
   unsigned long timeIoff;
-  TCB * searchPtr = ThreadList;
   OS_ENTERCRITICAL();
-  // Start the search pointer at the beginning of the list
 
+  // The idle thread runs if this was the last thread that could run
+  Sched_ReadyRemove(CurrentThread);
 
-  // Search the list and find the thread that points to the
-  // one to be removed.
-  while((searchPtr->next) != CurrentThread)
-  {
-    searchPtr = searchPtr->next;
-  }
-
-  // Do not kill the thread if it is the last element in the list
-  if(CurrentThread->next != CurrentThread)
-  {
-    // Remove the current thread from the linked list by assigning
-    // the pointer of the previous thread to the thread ahead of the
-    // element to be removed. 
-    searchPtr->next = CurrentThread->next;
+  DeadStack = CurrentThread->stackBase;
 
-    // Reassign the beginning of the list if removing first element 
-    if(ThreadList == CurrentThread)
-    {
-      ThreadList = CurrentThread->next;
-    }
-	// Indicate to AddThread that this spot is open
-    CurrentThread->id = DEAD;
-  }
+  // Indicate to AddThread that this spot is open
+  CurrentThread->id = DEAD;
 
   OS_EXITCRITICAL();
 
@@ -751,305 +815,1352 @@ OS_Id(void)
 
 //***********************************************************************
 //
-// OS_Fifo_Init
+// OS_Fifo_Init empties the FIFO used by OS_Fifo_Put and OS_Fifo_Get.
+//
+// \param size is the number of entries, 1 to MAX_OS_FIFOSIZE.
+// \return SUCCESS, or FAIL if \param size is out of range, and the FIFO
+// is left unchanged.
 //
 //***********************************************************************
-void
+int
 OS_Fifo_Init(unsigned int size)
 {
-  long sr = 0;
-  unsigned long timeIoff;
-  OS_ENTERCRITICAL();
-
-  PutPt = GetPt = &Fifo[0];
-  FifoSize = size;
-  OS_InitSemaphore(&fifoDataReady,0);
-  
-
-  OS_EXITCRITICAL();  
+  if(size > MAX_OS_FIFOSIZE)
+  {
+    return FAIL;
+  }
+  return OS_Fifo_Create(&OSFifo, OSFifoBuffer, size);
 }
 
 //***********************************************************************
 //
-// OS_Fifo_Get
+// OS_Fifo_Get takes the oldest entry out of the FIFO, blocking until the
+// producer puts one in.
 //
 //***********************************************************************
 unsigned int
 OS_Fifo_Get(unsigned long * dataPtr)
 {
-  if(PutPt == GetPt ){
-    return FAIL;// Empty if PutPt=GetPt
-  }
-  else{
-  OS_Wait(&fifoDataReady);
-  *dataPtr = *(GetPt++);
-    if(GetPt==&Fifo[FifoSize]){
-      GetPt = &Fifo[0]; // wrap
-    }
-    return SUCCESS;
-  }
+  return OS_Fifo_Recv(&OSFifo, dataPtr);
 }
 
 //***********************************************************************
 //
-// OS_Fifo_Put
+// OS_Fifo_Put puts an entry in the FIFO.  Does not block, so it may be
+// called from an ISR.
+//
+// \return SUCCESS, or FAIL if the FIFO is full.
 //
 //***********************************************************************
 unsigned int
 OS_Fifo_Put(unsigned long data)
 {
-  dataType volatile *nextPutPt;
-  nextPutPt = PutPt+1;
-  if(nextPutPt ==&Fifo[FifoSize]){
-    nextPutPt = &Fifo[0]; // wrap
-  }
-  if(nextPutPt == GetPt){
-    return FAIL; // Failed, fifo full
-  }
-  else{
-    *(PutPt) = data; // Put
-    PutPt = nextPutPt; // Success, update
-	OS_Signal(&fifoDataReady);
-    return SUCCESS;
-  }
+  return OS_Fifo_Send(&OSFifo, data);
 }
 
 //***********************************************************************
 //
-// OS_MailBox_Init
+// OS_Fifo_Create makes an empty FIFO that keeps its entries in buffer.
+// Entries are put with OS_Fifo_Send or OS_Fifo_SendN, which never block,
+// and taken in order with OS_Fifo_Recv, OS_Fifo_TryRecv,
+// OS_Fifo_RecvTimeout or OS_Fifo_RecvN.  Any number of threads may get
+// from the same FIFO.
 //
-//***********************************************************************
-void
-OS_MailBox_Init(void)
-{
-  MailBox1 = 0;
-}
-
-//***********************************************************************
+// \param fifoPt is the FIFO.
+// \param buffer is the storage for the entries, owned by the FIFO from
+// now on.
+// \param size is the number of entries in buffer, 1 to 32767.
 //
-// OS_MailBox_Send
+// \return SUCCESS, or FAIL if \param size is out of range.
 //
 //***********************************************************************
-void
-OS_MailBox_Send(unsigned long data)
+int
+OS_Fifo_Create(FifoType *fifoPt, unsigned long *buffer, unsigned long size)
 {
-  MailBox1 = data;
+  long sr = 0;
+  unsigned long timeIoff;
+
+  // The number of entries is kept in a semaphore
+  if((size == 0) || (size > 0x7FFF))
+  {
+    return FAIL;
+  }
+  OS_ENTERCRITICAL();
+
+  fifoPt->buffer = buffer;
+  fifoPt->size = size;
+  fifoPt->count = 0;
+  fifoPt->putIndex = 0;
+  fifoPt->getIndex = 0;
+  fifoPt->lost = 0;
+  OS_InitSemaphore(&(fifoPt->dataReady), 0);
+
+  OS_EXITCRITICAL();
+  return SUCCESS;
 }
 
 //***********************************************************************
 //
-// OS_MailBox_Recv
+// FifoTake copies the oldest entries out of a FIFO.  The caller has
+// already taken them from the dataReady count and is in a critical
+// section.
 //
 //***********************************************************************
-unsigned long
-OS_MailBox_Recv(void)
+static void
+FifoTake(FifoType *fifoPt, unsigned long data[], unsigned long num)
 {
-  return MailBox1;
+  unsigned long i;
+
+  for(i = 0; i < num; i++)
+  {
+    data[i] = fifoPt->buffer[fifoPt->getIndex];
+    fifoPt->getIndex++;
+    if(fifoPt->getIndex == fifoPt->size)
+    {
+      fifoPt->getIndex = 0;
+    }
+  }
+  fifoPt->count -= num;
 }
 
 //***********************************************************************
 //
-// OS_MsTime
+// OS_Fifo_Send puts an entry in a FIFO and wakes the highest priority
+// thread waiting for one.  Does not block, so it may be called from an
+// ISR.
 //
-// \param none
-//
-// This function returns the current value of the SysTick timer used to 
-// switch threads.
+// \param fifoPt is the FIFO.
+// \param data is the entry.
 //
-// \return counter value.
+// \return SUCCESS, or FAIL if the FIFO is full.
 //
 //***********************************************************************
-unsigned long OS_Time(void)
+int
+OS_Fifo_Send(FifoType *fifoPt, unsigned long data)
 {
-  return TimerValueGet(TIMER1_BASE, TIMER_A);
+  return (OS_Fifo_SendN(fifoPt, &data, 1) == 1) ? SUCCESS : FAIL;
 }
 
 //***********************************************************************
 //
-// OS_TimeDifference returns the time difference in usec.
+// OS_Fifo_SendN puts as many entries as there is room for in a FIFO, in
+// one critical section.  Does not block, so it may be called from an
+// ISR.  Entries that do not fit are counted in the FIFO's lost count.
+//
+// \param fifoPt is the FIFO.
+// \param data is the entries, oldest first.
+// \param num is the number of entries.
+//
+// \return the number of entries put.
 //
 //***********************************************************************
-long OS_TimeDifference(unsigned long time1, unsigned long time2)
-//                                   thisTime          	  LastTime
+unsigned long
+OS_Fifo_SendN(FifoType *fifoPt, const unsigned long data[], unsigned long num)
 {
-  if(time2 >= time1)
+  unsigned long i;
+  long sr = 0;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+
+  if(num > fifoPt->size - fifoPt->count)
   {
-  	return (long)(time2-time1);
+    fifoPt->lost += num - (fifoPt->size - fifoPt->count);
+    num = fifoPt->size - fifoPt->count;
   }
-  else
+  for(i = 0; i < num; i++)
   {
-    return (long)(time2 + (MAX_TCNT-time1));      
-  } 
+    fifoPt->buffer[fifoPt->putIndex] = data[i];
+    fifoPt->putIndex++;
+    if(fifoPt->putIndex == fifoPt->size)
+    {
+      fifoPt->putIndex = 0;
+    }
+    fifoPt->count++;
+    OS_Signal(&(fifoPt->dataReady));
+  }
+
+  OS_EXITCRITICAL();
+  return num;
 }
+
 //***********************************************************************
 //
-// OS_DebugProfileInit initializes GPIO port B pins 0 and 1 for time profiling
+// OS_Fifo_Recv takes the oldest entry out of a FIFO, blocking until
+// there is one.
 //
-// \param none.
-// \return none.
+// \param fifoPt is the FIFO.
+// \param dataPtr is where the entry goes.
+//
+// \return SUCCESS.
 //
 //***********************************************************************
-void
-OS_DebugProfileInit(void)
+int
+OS_Fifo_Recv(FifoType *fifoPt, unsigned long *dataPtr)
 {
-  SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
-  GPIOPinTypeGPIOOutput(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3);  
+  long sr = 0;
+  unsigned long timeIoff;
+
+  OS_Wait(&(fifoPt->dataReady));
+  OS_ENTERCRITICAL();
+  FifoTake(fifoPt, dataPtr, 1);
+  OS_EXITCRITICAL();
+  return SUCCESS;
 }
 
 //***********************************************************************
 //
-// OS_DebugB0Set sets PortB0 to 1
+// OS_Fifo_TryRecv takes the oldest entry out of a FIFO if there is one.
+// Does not block, so it may be called from an ISR.
 //
-// \param none.
-// \return none.
+// \param fifoPt is the FIFO.
+// \param dataPtr is where the entry goes.
+//
+// \return SUCCESS, or FAIL if the FIFO is empty.
 //
 //***********************************************************************
-void
-OS_DebugB0Set(void)
-{
-  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_0, 1);
-}
-void
-OS_DebugB1Set(void)
+int
+OS_Fifo_TryRecv(FifoType *fifoPt, unsigned long *dataPtr)
 {
-  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_1, 1);
+  return (OS_Fifo_RecvTimeout(fifoPt, dataPtr, 0) == SUCCESS) ? SUCCESS : FAIL;
 }
 
 //***********************************************************************
 //
-// OS_DebugB0Clear sets PortB0 to 0
+// OS_Fifo_RecvTimeout takes the oldest entry out of a FIFO, blocking
+// until there is one or the timeout runs out.
 //
-// \param none.
-// \return none.
+// \param fifoPt is the FIFO.
+// \param dataPtr is where the entry goes.
+// \param timeout is the longest wait in ms, 0 does not wait.
+//
+// \return SUCCESS, or TIMEOUT if the timeout ran out first.
 //
 //***********************************************************************
-void
-OS_DebugB0Clear(void)
+int
+OS_Fifo_RecvTimeout(FifoType *fifoPt, unsigned long *dataPtr, unsigned long timeout)
 {
-  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_0, 0);
+  long sr = 0;
+  unsigned long timeIoff;
+
+  if(OS_WaitTimeout(&(fifoPt->dataReady), timeout) == TIMEOUT)
+  {
+    return TIMEOUT;
+  }
+  OS_ENTERCRITICAL();
+  FifoTake(fifoPt, dataPtr, 1);
+  OS_EXITCRITICAL();
+  return SUCCESS;
+}
+
+//***********************************************************************
+//
+// OS_Fifo_RecvN blocks until a FIFO has an entry, then takes every entry
+// that is there, up to max, in one critical section.  A consumer can
+// sleep through a burst from its producer and handle all of it at once.
+//
+// \param fifoPt is the FIFO.
+// \param data is where the entries go, oldest first.
+// \param max is the most entries to take, at least 1.
+//
+// \return the number of entries taken.
+//
+//***********************************************************************
+unsigned long
+OS_Fifo_RecvN(FifoType *fifoPt, unsigned long data[], unsigned long max)
+{
+  if(max == 0)
+  {
+    return 0;
+  }
+  OS_Wait(&(fifoPt->dataReady));
+  return FifoTakeN(fifoPt, data, max);
+}
+
+//***********************************************************************
+//
+// OS_Fifo_RecvNTimeout is OS_Fifo_RecvN for no longer than the timeout.
+//
+// \param timeout is the longest wait in ms, 0 does not wait.
+//
+// \return the number of entries taken, 0 if the timeout ran out first.
+//
+//***********************************************************************
+unsigned long
+OS_Fifo_RecvNTimeout(FifoType *fifoPt, unsigned long data[], unsigned long max,
+                     unsigned long timeout)
+{
+  if((max == 0) || (OS_WaitTimeout(&(fifoPt->dataReady), timeout) == TIMEOUT))
+  {
+    return 0;
+  }
+  return FifoTakeN(fifoPt, data, max);
+}
+
+//***********************************************************************
+//
+// FifoTakeN takes the entry the caller waited for and every other entry
+// no getter has taken yet, up to max.
+//
+//***********************************************************************
+static unsigned long
+FifoTakeN(FifoType *fifoPt, unsigned long data[], unsigned long max)
+{
+  unsigned long num = 1;
+  long sr = 0;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+
+  // The wait took one entry, take the others that are not spoken for
+  if(fifoPt->dataReady.value > 0)
+  {
+    num += fifoPt->dataReady.value;
+    if(num > max)
+    {
+      num = max;
+    }
+    fifoPt->dataReady.value -= (short)(num - 1);
+  }
+  FifoTake(fifoPt, data, num);
+
+  OS_EXITCRITICAL();
+  return num;
+}
+
+//***********************************************************************
+//
+// OS_MailBox_Init empties the mailbox, a FIFO of one entry.  Data bigger
+// than one word goes through a message queue instead.
+//
+//***********************************************************************
+void
+OS_MailBox_Init(void)
+{
+  OS_Fifo_Create(&MailBox, &MailBoxData, 1);
+}
+
+//***********************************************************************
+//
+// OS_MailBox_Send puts data in the mailbox, replacing any data that has
+// not been received yet, and wakes a thread waiting in OS_MailBox_Recv.
+// Does not block, so it may be called from an ISR.
+//
+//***********************************************************************
+void
+OS_MailBox_Send(unsigned long data)
+{
+  long sr = 0;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+
+  if(MailBox.count == 1)
+  {
+    MailBoxData = data;
+  }
+  else
+  {
+    OS_Fifo_Send(&MailBox, data);
+  }
+
+  OS_EXITCRITICAL();
+}
+
+//***********************************************************************
+//
+// OS_MailBox_Recv returns the data in the mailbox, blocking until there
+// is data that has not been received.
+//
+//***********************************************************************
+unsigned long
+OS_MailBox_Recv(void)
+{
+  unsigned long data;
+
+  OS_Fifo_Recv(&MailBox, &data);
+  return data;
+}
+
+//***********************************************************************
+//
+// OS_MailBox_RecvTimeout is OS_MailBox_Recv for no longer than the
+// timeout.
+//
+// \param dataPtr is where the data goes.
+// \param timeout is the longest wait in ms, 0 does not wait.
+//
+// \return SUCCESS, or TIMEOUT if the timeout ran out first.
+//
+//***********************************************************************
+int
+OS_MailBox_RecvTimeout(unsigned long *dataPtr, unsigned long timeout)
+{
+  return OS_Fifo_RecvTimeout(&MailBox, dataPtr, timeout);
+}
+
+//***********************************************************************
+//
+// OS_MsgQueue_Create makes an empty message queue.  A message queue
+// passes pointers to buffers between threads and ISRs, so a message of
+// any size moves without being copied.  A successful send hands the
+// buffer to the queue, and the receiver owns it from then on, until it
+// passes it on in turn (back to a queue of free buffers, for one).
+//
+// \param queuePt is the queue.
+// \param slots is the storage for the queued pointers, owned by the
+// queue from now on.
+// \param size is the number of slots, 1 to 32767.
+//
+// \return SUCCESS, or FAIL if \param size is out of range.
+//
+//***********************************************************************
+int
+OS_MsgQueue_Create(MsgQueueType *queuePt, void *slots[], unsigned long size)
+{
+  // A pointer fits in an unsigned long on the board and on the host
+  return OS_Fifo_Create(&(queuePt->fifo), (unsigned long *)slots, size);
+}
+
+//***********************************************************************
+//
+// OS_MsgQueue_Send hands a message to a queue and wakes the highest
+// priority thread waiting for one.  Does not block, so it may be called
+// from an ISR.
+//
+// \param queuePt is the queue.
+// \param msgPt is the message, owned by the queue if the send succeeds.
+//
+// \return SUCCESS, or FAIL if the queue is full and the caller still
+// owns the message.
+//
+//***********************************************************************
+int
+OS_MsgQueue_Send(MsgQueueType *queuePt, void *msgPt)
+{
+  return OS_Fifo_Send(&(queuePt->fifo), (unsigned long)msgPt);
+}
+
+//***********************************************************************
+//
+// OS_MsgQueue_Recv takes the oldest message out of a queue, blocking
+// until there is one.  The caller owns the message.
+//
+// \param queuePt is the queue.
+//
+// \return the message.
+//
+//***********************************************************************
+void *
+OS_MsgQueue_Recv(MsgQueueType *queuePt)
+{
+  unsigned long msg;
+
+  OS_Fifo_Recv(&(queuePt->fifo), &msg);
+  return (void *)msg;
+}
+
+//***********************************************************************
+//
+// OS_MsgQueue_RecvTimeout takes the oldest message out of a queue,
+// blocking until there is one or the timeout runs out.  Does not block
+// with a timeout of 0, so it may then be called from an ISR.
+//
+// \param queuePt is the queue.
+// \param msgPt is where the message goes, owned by the caller on
+// SUCCESS.
+// \param timeout is the longest wait in ms, 0 does not wait.
+//
+// \return SUCCESS, or TIMEOUT if the timeout ran out first.
+//
+//***********************************************************************
+int
+OS_MsgQueue_RecvTimeout(MsgQueueType *queuePt, void **msgPt, unsigned long timeout)
+{
+  unsigned long msg;
+
+  if(OS_Fifo_RecvTimeout(&(queuePt->fifo), &msg, timeout) == TIMEOUT)
+  {
+    return TIMEOUT;
+  }
+  *msgPt = (void *)msg;
+  return SUCCESS;
+}
+
+//***********************************************************************
+//
+// OS_Time
+//
+// \param none
+//
+// This function returns the low 32 bits of the system timebase, which
+// counts up in 20 ns clock cycles and wraps every 85.9 seconds.
+//
+// \return time in clock cycles.
+//
+//***********************************************************************
+unsigned long OS_Time(void)
+{
+  return Timebase_Now();
+}
+
+//***********************************************************************
+//
+// OS_TimeDifference returns the time in clock cycles from time2 to 
+// time1.  Both must be OS_Time values less than 85.9 seconds apart.
+//
+//***********************************************************************
+long OS_TimeDifference(unsigned long time1, unsigned long time2)
+//                                   thisTime          	  LastTime
+{
+  return (long)(time1 - time2);
+}
+
+//***********************************************************************
+//
+// OS_ChargeIsr adds the time an interrupt handler has run to its ISR
+// class.  This time is not charged to the thread that was interrupted.
+//
+// \param isrClass is the ISR class, ISR_PERIODIC through ISR_CAN.
+// \param startTime is OS_Time at the start of the handler.
+// \return none.
+//
+//***********************************************************************
+void
+OS_ChargeIsr(unsigned char isrClass, unsigned long startTime)
+{
+  long sr;
+  unsigned long timeIoff;
+  unsigned long elapsed;
+  OS_ENTERCRITICAL();
+
+  elapsed = OS_TimeDifference(OS_Time(), startTime);
+  IsrRunTime[isrClass] += elapsed;
+  IsrCycles += elapsed;
+  Trace_Event(TRACE_ISR_EXIT, isrClass, 0);
+
+  OS_EXITCRITICAL();
+}
+//***********************************************************************
+//
+// OS_CriticalExit records how long interrupts were disabled by a critical
+// section, if OS_PROFILE_CRITICAL is set.  It is called by OS_EXITCRITICAL
+// with interrupts still disabled.  Nested sections are not counted.  No
+// section spans a thread switch, since OS_Wait and the other blocking
+// calls leave theirs before they suspend.
+//
+// \param sr is the interrupt state before the section.
+// \param startTime is OS_Time at the start of the section.
+// \param site is the call site's index into CritSites, 0 until assigned.
+// \param file and \param line name the call site.
+// \return none.
+//
+//***********************************************************************
+void
+OS_CriticalExit(long sr, unsigned long startTime, unsigned char * site, 
+                const char * file, unsigned short line)
+{
+  unsigned long elapsed = OS_TimeDifference(OS_Time(), startTime);
+  unsigned long usec;
+  int bucket;
+  CritSiteType * sitePt;
+
+  if(sr != 0)
+  {
+    return;
+  }
+
+  usec = elapsed/(1000/CLOCK_PERIOD);
+  for(bucket = 0; (usec != 0) && (bucket < CRIT_BUCKETS-1); bucket++)
+  {
+    usec >>= 1;
+  }
+  CritHistogram[bucket]++;
+
+  if(*site == 0)
+  {
+    if(CritNumSites == CRIT_SITES)
+    {
+      return;
+    }
+    CritSites[CritNumSites].file = file;
+    CritSites[CritNumSites].line = line;
+    CritNumSites++;
+    *site = CritNumSites;
+  }
+  sitePt = &CritSites[*site - 1];
+  sitePt->count++;
+  if(elapsed > sitePt->max)
+  {
+    sitePt->max = elapsed;
+  }
+  if(elapsed > TimeIbitDisabled)
+  {
+    TimeIbitDisabled = elapsed;
+    CritMaxSite = sitePt;
+  }
+}
+
+//***********************************************************************
+//
+// OS_DebugProfileInit initializes GPIO port B pins 0 and 1 for time profiling
+//
+// \param none.
+// \return none.
+//
+//***********************************************************************
+void
+OS_DebugProfileInit(void)
+{
+  SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
+  GPIOPinTypeGPIOOutput(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3);  
+}
+
+//***********************************************************************
+//
+// OS_DebugB0Set sets PortB0 to 1
+//
+// \param none.
+// \return none.
+//
+//***********************************************************************
+void
+OS_DebugB0Set(void)
+{
+  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_0, 1);
+}
+void
+OS_DebugB1Set(void)
+{
+  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_1, 1);
+}
+
+//***********************************************************************
+//
+// OS_DebugB0Clear sets PortB0 to 0
+//
+// \param none.
+// \return none.
+//
+//***********************************************************************
+void
+OS_DebugB0Clear(void)
+{
+  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_0, 0);
+}
+void
+OS_DebugB1Clear(void)
+{
+  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_1, 0);
+}
+
+
+//***********************************************************************
+//
+//  OS_InitSemaphore initializes semaphore within the OS to a given 
+//  value.
+//
+// /param
+//
+//***********************************************************************
+
+void 
+OS_InitSemaphore(Sema4Type *semaPt, unsigned int value)
+{
+  long sr = 0;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+
+  (semaPt->value) = value;
+  semaPt->waitList = NULL;
+
+  OS_EXITCRITICAL();
+}
+
+//***********************************************************************
+//
+//   OS_Signal signals a given semaphore.  If threads are blocked on the
+//   semaphore, the highest priority one is moved to the ready list.
+//
+//***********************************************************************
+
+void 
+OS_Signal(Sema4Type *semaPt)
+{
+  TCB * toUnblock;          // pointer to thread to unblock
+  long sr = 0;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  (semaPt->value)++;
+  if((semaPt->value) <= 0)
+  {
+     // The front of the wait queue is the highest priority waiter
+     toUnblock = Sched_WaitPop(&(semaPt->waitList));
+     if(toUnblock != NULL)
+     {
+       toUnblock->BlockPt = NULL;
+       Trace_Event(TRACE_SEM_WAKE, toUnblock->id, (unsigned short)(unsigned long)semaPt);
+       WakeThread(toUnblock);
+     }
+  }
+  OS_EXITCRITICAL();
+}
+
+//***********************************************************************
+//
+//   OS_Wait waits for a given semaphore.  A thread that has to wait is
+//   moved from the ready list to the semaphore's wait queue and does not
+//   run again until it is signaled.  If no other thread is ready the
+//   idle thread runs.
+//
+//***********************************************************************
+
+void 
+OS_Wait(Sema4Type *semaPt)
+{
+  long sr;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  (semaPt->value)--;
+  if((semaPt->value) < 0)
+  {
+     CurrentThread->BlockPt = semaPt;
+     Trace_Event(TRACE_SEM_BLOCK, CurrentThread->id, (unsigned short)(unsigned long)semaPt);
+     Sched_ReadyRemove(CurrentThread);
+     Sched_WaitInsert(&(semaPt->waitList), CurrentThread);
+  }
+  OS_EXITCRITICAL();
+
+  // PendSV is masked in a critical section, so the switch happens here
+  while(CurrentThread->state == THREAD_BLOCKED)
+  {
+    OS_Suspend();
+  }
+}
+
+//***********************************************************************
+//
+//   OS_WaitTimeout waits for a given semaphore for no longer than the
+//   timeout.  The waiting thread is on the semaphore's wait queue and in
+//   the sleep delta queue at the same time, whichever wakes it takes it
+//   out of the other.
+//
+// \param semaPt is the semaphore.
+// \param timeout is the longest wait in ms, 0 does not wait.
+//
+// \return SUCCESS, or TIMEOUT if the timeout ran out first.
+//
+//***********************************************************************
+
+int 
+OS_WaitTimeout(Sema4Type *semaPt, unsigned long timeout)
+{
+  long sr;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  if((semaPt->value) > 0)
+  {
+    (semaPt->value)--;
+    OS_EXITCRITICAL();
+    return SUCCESS;
+  }
+  if((timeout == 0) || (CurrentThread == NULL))
+  {
+    OS_EXITCRITICAL();
+    return TIMEOUT;
+  }
+
+  (semaPt->value)--;
+  CurrentThread->BlockPt = semaPt;
+  Trace_Event(TRACE_SEM_BLOCK, CurrentThread->id, (unsigned short)(unsigned long)semaPt);
+  Sched_ReadyRemove(CurrentThread);
+  Sched_WaitInsert(&(semaPt->waitList), CurrentThread);
+  Sched_TimeoutInsert(CurrentThread, timeout);
+  OS_EXITCRITICAL();
+
+  while(CurrentThread->state == THREAD_BLOCKED)
+  {
+    OS_Suspend();
+  }
+  return CurrentThread->timedOut ? TIMEOUT : SUCCESS;
+}
+
+//***********************************************************************
+//
+//   OS_bSignal signals binary semaphore.  A waiting thread takes it
+//   right away, the highest priority one first, otherwise the value
+//   becomes 1.  Does not block, so it may be called from an ISR.
+//
+//***********************************************************************
+
+void 
+OS_bSignal(Sema4Type *semaPt)
+{
+  TCB * toUnblock;
+  long sr = 0;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  toUnblock = Sched_WaitPop(&(semaPt->waitList));
+  if(toUnblock != NULL)
+  {
+    Trace_Event(TRACE_SEM_WAKE, toUnblock->id, (unsigned short)(unsigned long)semaPt);
+    WakeThread(toUnblock);
+  }
+  else
+  {
+    (semaPt->value) = 1;
+  }
+  OS_EXITCRITICAL();
+}
+
+//***********************************************************************
+//
+//   BWait is OS_bWait and OS_bWaitTimeout.  A thread that has to wait is
+//   on the semaphore's wait queue with the value left at 0, so a timeout
+//   has no count to give back.
+//
+//***********************************************************************
+
+static int
+BWait(Sema4Type *semaPt, unsigned long timeout, int forever)
+{
+  long sr;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  if((semaPt->value) == 1)
+  {
+    (semaPt->value) = 0;
+    OS_EXITCRITICAL();
+    return SUCCESS;
+  }
+  if((CurrentThread == NULL) || (!forever && (timeout == 0)))
+  {
+    OS_EXITCRITICAL();
+    return TIMEOUT;
+  }
+
+  CurrentThread->timedOut = 0;
+  Trace_Event(TRACE_SEM_BLOCK, CurrentThread->id, (unsigned short)(unsigned long)semaPt);
+  Sched_ReadyRemove(CurrentThread);
+  Sched_WaitInsert(&(semaPt->waitList), CurrentThread);
+  if(!forever)
+  {
+    Sched_TimeoutInsert(CurrentThread, timeout);
+  }
+  OS_EXITCRITICAL();
+
+  while(CurrentThread->state == THREAD_BLOCKED)
+  {
+    OS_Suspend();
+  }
+  return CurrentThread->timedOut ? TIMEOUT : SUCCESS;
+}
+
+//***********************************************************************
+//
+//   OS_bWait waits for binary semaphore, blocking until it is signaled.
+//
+//***********************************************************************
+
+void 
+OS_bWait(Sema4Type *semaPt)
+{
+  BWait(semaPt, 0, 1);
+}
+
+//***********************************************************************
+//
+//   OS_bWaitTimeout waits for binary semaphore for no longer than the
+//   timeout.
+//
+// \param semaPt is the binary semaphore.
+// \param timeout is the longest wait in ms, 0 does not wait.
+//
+// \return SUCCESS, or TIMEOUT if the timeout ran out first.
+//
+//***********************************************************************
+
+int 
+OS_bWaitTimeout(Sema4Type *semaPt, unsigned long timeout)
+{
+  return BWait(semaPt, timeout, 0);
+}
+
+//***********************************************************************
+//
+//   OS_InitFlags initializes an event flag group with no waiters.
+//
+//***********************************************************************
+
+void 
+OS_InitFlags(FlagsType *flagsPt, unsigned long flags)
+{
+  flagsPt->flags = flags;
+  flagsPt->waitList = NULL;
+}
+
+//***********************************************************************
+//
+//   FlagsMatch returns the flags in \param mask that are set, or 0 if
+//   that is not enough for \param mode.
+//
+//***********************************************************************
+
+static unsigned long
+FlagsMatch(unsigned long flags, unsigned long mask, unsigned char mode)
+{
+  unsigned long match = flags & mask;
+
+  if((mode & FLAGS_ALL) && (match != mask))
+  {
+    return 0;
+  }
+  return match;
+}
+
+//***********************************************************************
+//
+//   OS_SetFlags sets flags in an event flag group and wakes every thread
+//   whose wait they satisfy, highest priority first.  A waiter that
+//   asked for FLAGS_CLEAR takes the flags that woke it, so the ones
+//   behind it do not see them.  Does not block, so it may be called
+//   from an ISR.
+//
+//***********************************************************************
+
+void 
+OS_SetFlags(FlagsType *flagsPt, unsigned long flags)
+{
+  TCB * thread;
+  TCB * next;
+  TCB * last;
+  unsigned long match;
+  int done;
+  long sr;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  flagsPt->flags |= flags;
+  thread = flagsPt->waitList;
+  if(thread != NULL)
+  {
+    // Walk the queue once, a woken thread leaves it
+    last = thread->prev;
+    do
+    {
+      next = thread->next;
+      done = (thread == last);
+      match = FlagsMatch(flagsPt->flags, thread->flagsWait, thread->flagsMode);
+      if(match != 0)
+      {
+        if(thread->flagsMode & FLAGS_CLEAR)
+        {
+          flagsPt->flags &= ~match;
+        }
+        thread->flagsWait = match;
+        Sched_WaitRemove(thread);
+        WakeThread(thread);
+      }
+      thread = next;
+    }
+    while(!done);
+  }
+  OS_EXITCRITICAL();
+}
+
+//***********************************************************************
+//
+//   OS_ClearFlags clears flags in an event flag group.
+//
+//***********************************************************************
+
+void 
+OS_ClearFlags(FlagsType *flagsPt, unsigned long flags)
+{
+  long sr;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  flagsPt->flags &= ~flags;
+  OS_EXITCRITICAL();
+}
+
+//***********************************************************************
+//
+//   WaitFlags is OS_WaitFlags and OS_WaitFlagsTimeout, a thread that
+//   has to wait is on the group's wait queue until OS_SetFlags wakes it
+//   or its timeout runs out.
+//
+//***********************************************************************
+
+static unsigned long
+WaitFlags(FlagsType *flagsPt, unsigned long mask, unsigned char mode, 
+          unsigned long timeout, int forever)
+{
+  unsigned long match;
+  long sr;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+  match = FlagsMatch(flagsPt->flags, mask, mode);
+  if(match != 0)
+  {
+    if(mode & FLAGS_CLEAR)
+    {
+      flagsPt->flags &= ~match;
+    }
+    OS_EXITCRITICAL();
+    return match;
+  }
+  if((mask == 0) || (CurrentThread == NULL) || (!forever && (timeout == 0)))
+  {
+    OS_EXITCRITICAL();
+    return 0;
+  }
+
+  CurrentThread->flagsWait = mask;
+  CurrentThread->flagsMode = mode;
+  CurrentThread->timedOut = 0;
+  Sched_ReadyRemove(CurrentThread);
+  Sched_WaitInsert(&(flagsPt->waitList), CurrentThread);
+  if(!forever)
+  {
+    Sched_TimeoutInsert(CurrentThread, timeout);
+  }
+  OS_EXITCRITICAL();
+
+  while(CurrentThread->state == THREAD_BLOCKED)
+  {
+    OS_Suspend();
+  }
+  return CurrentThread->timedOut ? 0 : CurrentThread->flagsWait;
 }
-void
-OS_DebugB1Clear(void)
+
+//***********************************************************************
+//
+//   OS_WaitFlags waits until the flags in \param mask are set in an
+//   event flag group, any of them with FLAGS_ANY or all of them with
+//   FLAGS_ALL.  With FLAGS_CLEAR the flags that end the wait are
+//   cleared.
+//
+// \param flagsPt is the event flag group.
+// \param mask is the flags to wait for, not 0.
+// \param mode is FLAGS_ANY or FLAGS_ALL, plus FLAGS_CLEAR to clear them.
+//
+// \return the flags in \param mask that were set.
+//
+//***********************************************************************
+
+unsigned long 
+OS_WaitFlags(FlagsType *flagsPt, unsigned long mask, unsigned char mode)
 {
-  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_1, 0);
+  return WaitFlags(flagsPt, mask, mode, 0, 1);
 }
 
-
 //***********************************************************************
 //
-//  OS_InitSemaphore initializes semaphore within the OS to a given 
-//  value.
+//   OS_WaitFlagsTimeout is OS_WaitFlags for no longer than the timeout.
 //
-// /param
+// \param timeout is the longest wait in ms, 0 does not wait.
+//
+// \return the flags in \param mask that were set, or 0 if the timeout
+// ran out first.
+//
+//***********************************************************************
+
+unsigned long 
+OS_WaitFlagsTimeout(FlagsType *flagsPt, unsigned long mask, unsigned char mode,
+                    unsigned long timeout)
+{
+  return WaitFlags(flagsPt, mask, mode, timeout, 0);
+}
+
+//***********************************************************************
+//
+//   OS_InitMutex initializes a priority inheritance mutex to unlocked.
 //
 //***********************************************************************
 
 void 
-OS_InitSemaphore(Sema4Type *semaPt, unsigned int value)
+OS_InitMutex(MutexType *mutexPt)
 {
   long sr = 0;
   unsigned long timeIoff;
   OS_ENTERCRITICAL();
 
-  (semaPt->value) = value;
+  mutexPt->owner = NULL;
+  mutexPt->waitList = NULL;
+  mutexPt->next = NULL;
+  mutexPt->inverted = 0;
+  mutexPt->inversions = 0;
+  mutexPt->maxInversion = 0;
 
   OS_EXITCRITICAL();
 }
 
 //***********************************************************************
 //
-//   OS_Signal signals a given semaphore.
+//   OS_MutexLock takes a mutex, blocking if another thread owns it.  
+//   While a thread is blocked, the owner (and whatever the owner is 
+//   blocked on in turn) runs at no lower than the blocked thread's 
+//   priority, so a higher priority thread waits for at most the owner's
+//   critical section.  The mutex is not recursive and must only be used
+//   by threads.
 //
 //***********************************************************************
 
 void 
-OS_Signal(Sema4Type *semaPt)
+OS_MutexLock(MutexType *mutexPt)
 {
-  TCB * temp = ThreadList;  // pointer to all threads in the threadlist
-  TCB * toUnblock = NULL;          // pointer to thread to unblock
-  unsigned long highest_priority = 100; 
-  long sr = 0;
-  unsigned long timeIoff;
-  OS_ENTERCRITICAL();
-  (semaPt->value)++;
-  if((semaPt->value) <= 0)
-  {
-     do
-     {
-       if(((temp->BlockPt) == semaPt) && (temp->priority < highest_priority)) 
-       {
-         toUnblock = temp;   // If a thread is blocked by this semaphore and 
-                             // is the highest priority, unblock the thread
-         highest_priority = toUnblock->priority;
-       }
-       temp = temp->next;
-     }
-     while(temp != ThreadList);
-     if(toUnblock->BlockPt != NULL && toUnblock != NULL)
-     {
-       toUnblock->BlockPt = NULL;
-     }
-  }
-  OS_EXITCRITICAL();
+  MutexLock(mutexPt, 0, 1);
 }
 
 //***********************************************************************
 //
-//   OS_Wait waits for a given semaphore.
+//   OS_MutexLockTimeout is OS_MutexLock for no longer than the timeout.
+//   When the wait times out the owner, and whatever the owner is blocked
+//   on in turn, gives up the priority it inherited from the waiter.
+//
+// \param mutexPt is the mutex.
+// \param timeout is the longest wait in ms, 0 does not wait.
+//
+// \return SUCCESS, or TIMEOUT if the timeout ran out first.
 //
 //***********************************************************************
 
-void 
-OS_Wait(Sema4Type *semaPt)
+int 
+OS_MutexLockTimeout(MutexType *mutexPt, unsigned long timeout)
+{
+  return MutexLock(mutexPt, timeout, 0);
+}
+
+//***********************************************************************
+//
+//   MutexLock is OS_MutexLock and OS_MutexLockTimeout.
+//
+//***********************************************************************
+
+static int
+MutexLock(MutexType *mutexPt, unsigned long timeout, int forever)
 {
+  TCB * owner;
   long sr;
   unsigned long timeIoff;
   OS_ENTERCRITICAL();
-  (semaPt->value)--;
-  if((semaPt->value) < 0)
+
+  // Before OS_Launch there is nothing to wait for
+  if(CurrentThread == NULL)
   {
-     CurrentThread->BlockPt = semaPt;
-     OS_Suspend();
+    OS_EXITCRITICAL();
+    return SUCCESS;
+  }
+
+  if(mutexPt->owner == NULL)
+  {
+    mutexPt->owner = CurrentThread;
+    mutexPt->next = CurrentThread->MutexList;
+    CurrentThread->MutexList = mutexPt;
+    OS_EXITCRITICAL();
+    return SUCCESS;
+  }
+  if(!forever && (timeout == 0))
+  {
+    OS_EXITCRITICAL();
+    return TIMEOUT;
+  }
+
+  // A lower priority owner is an inversion, time it until the unlock
+  owner = mutexPt->owner;
+  if((owner->priority > CurrentThread->priority) && !(mutexPt->inverted))
+  {
+    mutexPt->inverted = 1;
+    mutexPt->inversionStart = OS_Time();
+  }
+
+  // Pass our priority down the chain of owners
+  while((owner != NULL) && (owner->priority > CurrentThread->priority))
+  {
+    Sched_SetPriority(owner, CurrentThread->priority);
+    if(owner->MutexBlockPt != NULL)
+    {
+      owner = owner->MutexBlockPt->owner;
+    }
+    else
+    {
+      owner = NULL;
+    }
+  }
+
+  // The unlock hands the mutex straight to the highest priority waiter
+  CurrentThread->MutexBlockPt = mutexPt;
+  CurrentThread->timedOut = 0;
+  Sched_ReadyRemove(CurrentThread);
+  Sched_WaitInsert(&(mutexPt->waitList), CurrentThread);
+  if(!forever)
+  {
+    Sched_TimeoutInsert(CurrentThread, timeout);
+  }
+  OS_EXITCRITICAL();
+
+  while(CurrentThread->state == THREAD_BLOCKED)
+  {
+    OS_Suspend();
+  }
+  if(!CurrentThread->timedOut)
+  {
+    return SUCCESS;
+  }
+
+  // Take our priority back up the chain of owners, until an owner
+  // keeps the priority it had
+  OS_ENTERCRITICAL();
+  owner = mutexPt->owner;
+  while((owner != NULL) && (owner->priority != InheritedPriority(owner)))
+  {
+    Sched_SetPriority(owner, InheritedPriority(owner));
+    if(owner->MutexBlockPt != NULL)
+    {
+      owner = owner->MutexBlockPt->owner;
+    }
+    else
+    {
+      owner = NULL;
+    }
   }
   OS_EXITCRITICAL();
+  return TIMEOUT;
 }
 
 //***********************************************************************
 //
-//   OS_bSignal signals binary semaphore. 
+//   InheritedPriority returns the priority a mutex owner runs at, its
+//   own or that of the highest priority thread waiting on a mutex it
+//   owns.
 //
 //***********************************************************************
 
-void 
-OS_bSignal(Sema4Type *semaPt)
+static unsigned long
+InheritedPriority(TCB * thread)
 {
-  (semaPt->value) = 1;
+  MutexType * held;
+  unsigned long priority = thread->basePriority;
+
+  for(held = thread->MutexList; held != NULL; held = held->next)
+  {
+    if((held->waitList != NULL) && (held->waitList->priority < priority))
+    {
+      priority = held->waitList->priority;
+    }
+  }
+  return priority;
 }
 
 //***********************************************************************
 //
-//   OS_bSignal waits for binary semaphore.
+//   OS_MutexUnlock releases a mutex owned by the current thread.  The
+//   thread drops back to its own priority (or the highest priority still
+//   waiting on another mutex it owns) and the mutex goes to the highest
+//   priority waiter.
 //
 //***********************************************************************
 
 void 
-OS_bWait(Sema4Type *semaPt)
+OS_MutexUnlock(MutexType *mutexPt)
 {
-  IntMasterDisable();
-  while((semaPt->value) == 0)
+  TCB * next;
+  MutexType ** searchPt;
+  unsigned long inversion;
+  long sr;
+  unsigned long timeIoff;
+  OS_ENTERCRITICAL();
+
+  if((CurrentThread == NULL) || (mutexPt->owner != CurrentThread))
+  {
+    OS_EXITCRITICAL();
+    return;
+  }
+
+  // Take the mutex off the owner's list
+  searchPt = &(CurrentThread->MutexList);
+  while(*searchPt != mutexPt)
+  {
+    searchPt = &((*searchPt)->next);
+  }
+  *searchPt = mutexPt->next;
+
+  // Record how long a higher priority thread was held up, in usec
+  if(mutexPt->inverted)
+  {
+    inversion = OS_TimeDifference(OS_Time(), mutexPt->inversionStart)/(1000/CLOCK_PERIOD);
+    mutexPt->inverted = 0;
+    (mutexPt->inversions)++;
+    if(inversion > mutexPt->maxInversion)
+    {
+      mutexPt->maxInversion = inversion;
+    }
+    MutexInversions++;
+    MutexInversionTotal += inversion;
+    if(inversion > MutexInversionMax)
+    {
+      MutexInversionMax = inversion;
+    }
+  }
+
+  // Give up any priority inherited through this mutex
+  Sched_SetPriority(CurrentThread, InheritedPriority(CurrentThread));
+
+  // Hand the mutex to the highest priority waiter
+  next = Sched_WaitPop(&(mutexPt->waitList));
+  mutexPt->owner = next;
+  if(next != NULL)
   {
-  	IntMasterEnable();
+    next->MutexBlockPt = NULL;
+    mutexPt->next = next->MutexList;
+    next->MutexList = mutexPt;
+
+    // The new owner inherits from the threads still waiting
+    if((mutexPt->waitList != NULL) && (mutexPt->waitList->priority < next->priority))
+    {
+      next->priority = mutexPt->waitList->priority;
+      mutexPt->inverted = 1;
+      mutexPt->inversionStart = OS_Time();
+    }
+    WakeThread(next);
+  }
+
+  OS_EXITCRITICAL();
+}
 
-  	IntMasterDisable();
+//***********************************************************************
+//
+// WakeThread moves a thread that was blocked to the ready list, and
+// stops its wait timeout if it has one.  If it 
+// outranks the running thread a thread switch is pended, which happens
+// as soon as interrupts are enabled again (or the last ISR returns 
+// when called from an ISR).  Must be called in a critical section.
+//
+// \param thread is the TCB to wake.
+// \return none.
+//
+//***********************************************************************
+void
+WakeThread(TCB * thread)
+{
+  if(thread->timedWait)
+  {
+    Sched_SleepRemove(thread);
+  }
+  Sched_ReadyInsert(thread);
+  thread->wakeTime = OS_Time();
+  thread->wakePending = 1;
+#if OS_PREEMPT_ON_WAKE
+  if((CurrentThread != NULL) && (thread->priority < CurrentThread->priority))
+  {
+    HWREG(NVIC_INT_CTRL) = NVIC_INT_CTRL_PEND_SV;
   }
-  (semaPt->value) = 0;
-  IntMasterEnable();
+#endif
 }
 
 //***********************************************************************
 //
-// PerThreadSwitchInit initializes the SysTick timer to interrupt at the 
-// specified period to perform thread switching
+// PerThreadSwitchInit initializes the SysTick timer as the 1 ms OS tick
+// and sets the number of ticks per thread switch.  A period shorter
+// than 1 ms is used as the tick itself, and the ticks are added up into
+// whole milliseconds.
 //
 // \param period is the period at which threads will be swtiched
 // 
@@ -1063,11 +2174,23 @@ PerThreadSwitchInit(unsigned long period)
   // Enable SysTick Interrupts
   SysTickIntEnable();
 
-  // Set the period in ms
-  SysTickPeriodSet(period);
+  // Set the tick period and the number of ticks per timeslice
+  if(period >= TIME_1MS)
+  {
+    TickPeriod = TIME_1MS;
+    SliceTicks = period/TIME_1MS;
+  }
+  else
+  {
+    TickPeriod = period;
+    SliceTicks = 1;
+  }
+  TickAccum = 0;
+  SliceCount = SliceTicks;
+  SysTickPeriodSet(TickPeriod);
 
-  // Set Systick priority to high, PendSV priority to low
-  IntPrioritySet(FAULT_SYSTICK,(((unsigned char)0)<<5)&0xF0);
+  // Set Systick priority to the highest the kernel masks, PendSV priority to low
+  IntPrioritySet(FAULT_SYSTICK,(((unsigned char)OS_KERNEL_PRIORITY)<<5)&0xF0);
   IntPrioritySet(FAULT_PENDSV,(((unsigned char)7)<<5)&0xF0);
   
   // Enable the SysTick module  
@@ -1078,152 +2201,135 @@ PerThreadSwitchInit(unsigned long period)
 
 //***********************************************************************
 //
-// Timer 3A Interrupt handler, executes the user defined period task.
+// SysTick handler, advances the OS time and wakes sleeping threads,
+// enables PendSV for thread switching at the end of each timeslice.
 //
 //***********************************************************************
-long timeCheck;
-void
-Timer3AIntHandler(void)
-{
-  int index;
-  static unsigned long LastTime;  // time at previous interrupt  
-  static unsigned long thisTime;         // time at current interrupt
-  long jitter;                    // time between measured and expected
-
-  thisTime = OS_Time();
-  CumulativeRunTime += (OS_TimeDifference(thisTime, CumLastTime)*CLOCK_PERIOD)/1000;	//in ms
-  CumLastTime = thisTime;
-
-  if(EventIndex < NUM_EVENTS)
-  {
-    RunTimeProfile[EventIndex][0] = CumulativeRunTime;
-    RunTimeProfile[EventIndex][1] = PER_THREAD_START;
-	EventIndex++;
-  }
-
-  if(NumSamples < RUNLENGTH){
-    // Jitter calculation:
-    thisTime = OS_Time();       // current time, 20 ns
-    timeCheck = OS_TimeDifference(thisTime, LastTime);
-    jitter = ((OS_TimeDifference(thisTime, LastTime)-PeriodTimerA)*CLOCK_PERIOD)/1000;  // in usec
-	if(!firstJitterA){
-	  if(jitter > MaxJitterA){
-        MaxJitterA = jitter;
-      }
-      if(jitter < MinJitterA){
-        MinJitterA = jitter;
-      }        // jitter should be 0
-      index = jitter+JITTERSIZE/2;   // us units
-      if(index<0)index = 0;
-      if(index>=JitterSize)index = JITTERSIZE-1;
-      JitterHistogramA[index]++; 
-	}
-	firstJitterA = 0;
-  LastTime = thisTime;
-  }
-  // Execute the periodic thread
-  TimerIntClear(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
-  PeriodicTaskA();
-    
-  thisTime = OS_Time();
-  CumulativeRunTime += ((OS_TimeDifference(thisTime, CumLastTime)*CLOCK_PERIOD)/1000);	//in ms
-  CumLastTime = thisTime;
-  
-  if(EventIndex < NUM_EVENTS)
-  {
-    RunTimeProfile[EventIndex][0] = CumulativeRunTime;
-    RunTimeProfile[EventIndex][1] = PER_THREAD_END;
-	EventIndex++;
-  } 
-
-}
+unsigned long RunningCount;
 
 //***********************************************************************
 //
-// Timer 3B Interrupt handler, executes the user defined period task.
+// CpuLoadSecond updates the CPU load once a second from the time the
+// idle thread ran, ISRs count as load.  Called by the SysTick handler
+// in its critical section.
 //
 //***********************************************************************
-void
-Timer3BIntHandler(void)
+static void
+CpuLoadSecond(void)
 {
-  static unsigned long LastTime;  // time at previous interrupt  
-  static unsigned long thisTime;         // time at current interrupt 
-  long jitter;                    // time between measured and expected
-  int index;
- 
-  thisTime = OS_Time();
-  CumulativeRunTime += ((OS_TimeDifference(thisTime, CumLastTime)*CLOCK_PERIOD)/1000);	//in ms
-  CumLastTime = thisTime;
-  
-  if(EventIndex < NUM_EVENTS)
+  unsigned long long idleTime = IdleThread->runTime;
+  unsigned long idle, total;
+  long elapsed;
+  int i;
+
+  // The idle thread may have been running since the last switch
+  if(CurrentThread == IdleThread)
+  {
+    elapsed = OS_TimeDifference(OS_Time(), SwitchTime) - (IsrCycles - IsrCyclesAtSwitch);
+    if(elapsed > 0)
+    {
+      idleTime += elapsed;
+    }
+  }
+  idle = (unsigned long)(idleTime - IdleTimeAtSecond);
+  IdleTimeAtSecond = idleTime;
+  if(idle > 1000*TIME_1MS)
   {
-    RunTimeProfile[EventIndex][0] = CumulativeRunTime;
-    RunTimeProfile[EventIndex][1] = PER_THREAD_START;
-	EventIndex++;
+    idle = 1000*TIME_1MS;
   }
+  CpuLoad1s = 1000 - idle/TIME_1MS;
 
-  if(NumSamples < RUNLENGTH){
-    // Jitter calculation:
-    thisTime = OS_Time();       // current time, 20 ns
-    timeCheck = OS_TimeDifference(thisTime, LastTime);
-    jitter = ((OS_TimeDifference(thisTime, LastTime)-PeriodTimerB)*CLOCK_PERIOD)/1000;  // in usec
-	if(!firstJitterB){
-	  if(jitter > MaxJitterB){
-        MaxJitterB = jitter;
-      }
-      if(jitter < MinJitterB){
-        MinJitterB = jitter;
-      }        // jitter should be 0
-      index = jitter+JITTERSIZE/2;   // us units
-      if(index<0)index = 0;
-      if(index>=JitterSize)index = JITTERSIZE-1;
-      JitterHistogramB[index]++; 
-      LastTime = thisTime;
-	}
-	firstJitterB = 0;
-  }
-  // Execute Periodic task
-  TimerIntClear(TIMER3_BASE, TIMER_TIMB_TIMEOUT);
-  PeriodicTaskB();
-
-  thisTime = OS_Time();
-  CumulativeRunTime += ((OS_TimeDifference(thisTime, CumLastTime)*CLOCK_PERIOD)/1000);	//in ms
-  CumLastTime = thisTime;
-  
-  if(EventIndex < NUM_EVENTS)
+  IdleSeconds[IdleSecond] = idle;
+  IdleSecond = (IdleSecond + 1) % LOAD_WINDOW;
+  if(LoadSeconds < LOAD_WINDOW)
+  {
+    LoadSeconds++;
+  }
+  total = 0;
+  for(i = 0; i < LoadSeconds; i++)
   {
-    RunTimeProfile[EventIndex][0] = CumulativeRunTime;
-    RunTimeProfile[EventIndex][1] = PER_THREAD_END;
-	EventIndex++;
-  }   
+    total += IdleSeconds[i];
+  }
+  CpuLoad10s = 1000 - total/(LoadSeconds*TIME_1MS);
 }
 
 //***********************************************************************
 //
-// Timer 2A Interrupt handler, executes the user defined period task.
+// ButtonWork runs the tasks of the buttons that were just pressed.  The
+// SysTick handler defers it, so the tasks run in a thread.
+//
+// \param pressed has a bit set for each button, as in g_ucSwitches.
+// \return none.
 //
 //***********************************************************************
-void
-Timer2IntHandler(void)
+static void
+ButtonWork(unsigned long pressed)
 {
-
+  if((pressed & 0x10) && (ButtonTask != NULL))
+  {
+    ButtonTask();
+  }
+  if((pressed & 0x08) && (RightTask != NULL))
+  {
+    RightTask();
+  }
+  if((pressed & 0x04) && (LeftTask != NULL))
+  {
+    LeftTask();
+  }
+  if((pressed & 0x02) && (DownTask != NULL))
+  {
+    DownTask();
+  }
+  if((pressed & 0x01) && (UpTask != NULL))
+  {
+    UpTask();
+  }
 }
 
-//***********************************************************************
-//
-// SysTick handler, enables PendSV for thread switching.
-//
-//***********************************************************************
-unsigned long RunningCount;
-
 void
 SysTickThSwIntHandler(void)
 {   
-  unsigned long ulData, ulDelta, bumperData, bumperDelta; 
+  unsigned long ulData, ulDelta, bumperData, bumperDelta, pressed; 
   long sr = 0;
   unsigned long timeIoff;
   static char count;
+  unsigned long startTime = OS_Time();
+  Trace_Event(TRACE_ISR_ENTER, ISR_SYSTICK, 0);
   OS_ENTERCRITICAL();
+
+  // Advance the OS time one ms at a time, a thread that wakes up at a
+  // higher priority than the running thread runs right away
+  TickAccum += TickPeriod;
+  while(TickAccum >= TIME_1MS)
+  {
+    TickAccum -= TIME_1MS;
+    RunningCount++;
+    LoadCount--;
+    if(LoadCount == 0)
+    {
+      LoadCount = 1000;
+      CpuLoadSecond();
+    }
+    if(Sched_SleepTick() && (Sched_ReadyPriority() < CurrentThread->priority))
+    {
+      TriggerPendSV();
+    }
+  }
+
+  // Only switch threads at the end of the timeslice
+  SliceCount--;
+  if(SliceCount > 0)
+  {
+    OS_EXITCRITICAL();
+    OS_ChargeIsr(ISR_SYSTICK, startTime);
+    return;
+  }
+  SliceCount = SliceTicks;
+  TriggerPendSV();
+  OS_EXITCRITICAL();
+
+  // The debounce state is only touched here, it needs no critical section
   CANIntDisable(CAN0_BASE, CAN_INT_MASTER | CAN_INT_ERROR);
 //  if(g_sCAN.ulBytesRemaining !=0 && OS_Id() == 1)
 //  {
@@ -1283,27 +2389,12 @@ SysTickThSwIntHandler(void)
 	bumperDelta ^= (g_ucBprSwitchClkA | g_ucBprSwitchClkB); 
 
   
-  //If the button is still pressed, execute the user task.
-  if((ulDelta & 0x10) && !(g_ucSwitches & 0x10) && (ButtonTask != NULL))
-  {
-    ButtonTask();
-  }
-  if((ulDelta & 0x08) && !(g_ucSwitches & 0x08) && (RightTask != NULL))
-  {
-    RightTask();
-  }
-  if((ulDelta & 0x04) && !(g_ucSwitches & 0x04) && (LeftTask != NULL))
-  {
-    LeftTask();
-  }
-  if((ulDelta & 0x02) && !(g_ucSwitches & 0x02) && (DownTask != NULL))
+  //If the button is still pressed, execute the user task in a thread.
+  pressed = ulDelta & ~g_ucSwitches & 0x1F;
+  if(pressed != 0)
   {
-    DownTask();
+    OS_Defer(&ButtonWork, pressed);
   }
-  if((ulDelta & 0x01) && !(g_ucSwitches & 0x01) && (UpTask != NULL))
-  {
-    UpTask();
-  }                                    
   //Wait for the user to release the button
   //while(GPIOPinRead(GPIO_PORTF_BASE, GPIO_PIN_1));
   
@@ -1324,72 +2415,76 @@ SysTickThSwIntHandler(void)
   //TimerIntClear(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
   //GPIOPinIntEnable(GPIO_PORTF_BASE, GPIO_PIN_1);
 
-  TriggerPendSV();
-
-  RunningCount += TIMESLICE/TIME_1MS;
-
-  OS_EXITCRITICAL();  
+  OS_ChargeIsr(ISR_SYSTICK, startTime);
 }
 
 //***********************************************************************
 //
-// PendSV handler, switches threads.  Disables interrupts during execution.
+// PendSVSchedule picks the next thread and charges the time since the
+// last switch to the thread that was running.  Called by PendSVHandler
+// in OS_asm.s, which then switches to NextThread.
 //
 //***********************************************************************
 void 
-PendSVHandler(void)
+PendSVSchedule(void)
 {
-  TCB * TempPt;
-  static unsigned long RunPriorityLevel;
   long sr;
   unsigned long timeIoff;
   static unsigned long thisTime;
+  unsigned long latency;
+  long elapsed;
   OS_ENTERCRITICAL();
+
+  // Free the stack of a killed thread once a switch has left it.  This
+  // switch leaves a thread killed since the last one, and still saves
+  // its registers on its stack.
+  if(LeftStack != NULL)
+  {
+    Stack_Free(LeftStack);
+  }
+  LeftStack = DeadStack;
+  DeadStack = NULL;
+
+  // The next thread is the front of the highest priority ready list,
+  // sleeping and blocked threads are not on the ready lists.  With no
+  // thread ready the idle thread runs.
+  NextThread = Sched_PickNext(IdleThread);
+
+  // Measure how long a woken thread waited to run, in 0.1 usec
+  if(NextThread->wakePending)
+  {
+    latency = OS_TimeDifference(OS_Time(), NextThread->wakeTime)/(100/CLOCK_PERIOD);
+    NextThread->wakePending = 0;
+    WakeLatencyCount++;
+    WakeLatencyTotal += latency;
+    if(latency > WakeLatencyMax)
+    {
+      WakeLatencyMax = latency;
+    }
+  }
   
-  //Determine the priority level to run	and update sleeping threads
-  RunPriorityLevel = 100;     //Initialize to rediculously low priority
-  TempPt = ThreadList;
-  do
-  {
-    // Find lowest active priority level
-    if((TempPt->BlockPt == NULL)&&(TempPt->priority < RunPriorityLevel)&&(TempPt->sleepCount == 0))
-	{
-        RunPriorityLevel = TempPt->priority;
-	}
-	  // Decrement sleep counter on sleeping threads
-    if(TempPt->sleepCount > 0)
-	{
-      (TempPt->sleepCount)--;
-	}
-	TempPt = TempPt->next;
-  }while(TempPt != ThreadList);
-
-
-  // Find the next thread that is not...
-  // (1) Sleeping
-  // (2) Blocked or
-  // (3) Too low in priority
-  NextThread = CurrentThread;
-  do
-  {
-    NextThread = NextThread->next;
-  }while(((NextThread->sleepCount != 0)||(NextThread->BlockPt != NULL)||(NextThread->priority > RunPriorityLevel))&&(NextThread!=CurrentThread));
-  
-  HWREG(NVIC_ST_CURRENT) = 0;
+  // The next thread gets a full timeslice.  SysTick keeps running so
+  // the OS time is not disturbed by thread switches.
+  SliceCount = SliceTicks;
 
   thisTime = OS_Time();
-  CumulativeRunTime += ((OS_TimeDifference(thisTime, CumLastTime)*CLOCK_PERIOD)/1000);	//in ms
-  CumLastTime = thisTime;
 
-  if(EventIndex < NUM_EVENTS)
+  // Charge the time since the last switch, less the time spent in ISRs,
+  // to the thread that was running.  Cycles are added up here and only
+  // turned into percentages when someone asks.
+  elapsed = OS_TimeDifference(thisTime, SwitchTime) - (IsrCycles - IsrCyclesAtSwitch);
+  if(elapsed > 0)
+  {
+    CurrentThread->runTime += elapsed;
+  }
+  SwitchTime = thisTime;
+  IsrCyclesAtSwitch = IsrCycles;
+  if(NextThread != CurrentThread)
   {
-    RunTimeProfile[EventIndex][0] = CumulativeRunTime;
-    RunTimeProfile[EventIndex][1] = FOREGROUND_THREAD_START;
-	  EventIndex++;
+    NextThread->switches++;
+    Trace_Event(TRACE_SWITCH, CurrentThread->id, NextThread->id);
   }
   OS_EXITCRITICAL();
- 
-  SwitchThreads();  
 }
 
 //***********************************************************************
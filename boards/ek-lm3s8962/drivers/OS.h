@@ -6,21 +6,25 @@
 
 #define SUCCESS 1
 #define FAIL 0
+#define TIMEOUT 2					// a timed wait ran out first
 #define DEAD 0xFF
 #define BLOCKED 1
 #define UNBLOCKED 0
-#define MAX_NUM_OS_THREADS 10
-#define STACK_SIZE 2048 			//Stack size in bytes
+#define THREAD_READY 0				// TCB state: on a ready list
+#define THREAD_SLEEPING 1			// TCB state: in the sleep delta queue
+#define THREAD_BLOCKED 2			// TCB state: on a wait queue
+#define MAX_NUM_OS_THREADS 20
+#define NUM_PRIORITIES 32 			// thread priorities 0 (highest) to 31
 #define MAX_THREAD_SW_PER_MS 1000
 #define MIN_THREAD_SW_PER_MS 1
 #define MAX_OS_FIFOSIZE 128 		// can be any size
 #define CLOCK_PERIOD 20  			// clock period in ns
-#define MAX_TCNT  0x0EE6B280			// @50Mhz, this is 5 seconds
 #define JITTERSIZE 64
-#define NUM_EVENTS 100
-#define PER_THREAD_START 0x04
-#define PER_THREAD_END   0x08
-#define FOREGROUND_THREAD_START 0x03
+#define ISR_PERIODIC 0				// ISR classes charged by OS_ChargeIsr
+#define ISR_SYSTICK 1
+#define ISR_UART 2
+#define ISR_CAN 3
+#define NUM_ISR_CLASSES 4
 
 #define TIME_1MS 50000		  		// #clock cycles per ms in 50MHz mode
 #define TIMESLICE TIME_1MS*2  		//Thread switching period in ms
@@ -30,19 +34,113 @@
 
 #define RUN_TIME 180000
 
+#define OS_PREEMPT_ON_WAKE 1  // 1: a woken thread that outranks the running
+                              // thread runs right away, 0: at the next TIMESLICE
+
+#define OS_KERNEL_PRIORITY 1  // highest NVIC priority (1-7) masked by critical
+                              // sections.  ISRs above it (priority 0) are never
+                              // delayed by the kernel and must not call the OS.
+#define OS_BASEPRI (OS_KERNEL_PRIORITY << 5)  // BASEPRI value of a critical section
+
+#define IDLE_PRIORITY NUM_PRIORITIES  // below every thread priority, the idle thread
+#define OS_USER_PRIORITY 1    // highest priority OS_AddThread gives, 0 is kept
+                              // for the deferred work thread
+#define IDLE_STACK_SIZE 256   // bytes, the idle thread only waits for interrupts
+#define LOAD_WINDOW 10        // seconds in the long CPU load average
+
+#define FLAGS_ANY 0		  // OS_WaitFlags modes: wait for any of the flags
+#define FLAGS_ALL 1		  // wait for all of them
+#define FLAGS_CLEAR 2	  // and clear the flags that end the wait
+
+#define OS_PROFILE_CRITICAL 0 // 1: time every critical section, see the Crit command
+#define CRIT_SITES 32		  // critical sections that get their own statistics
+#define CRIT_BUCKETS 12		  // histogram buckets, powers of 2 usec
+
+//*****************************************************************************
+//
+// Critical sections.  The caller declares long sr and unsigned long
+// timeIoff.  A critical section raises BASEPRI to OS_BASEPRI, so it only
+// masks the interrupts at OS_KERNEL_PRIORITY and below.  With
+// OS_PROFILE_CRITICAL each call site keeps its own index into CritSites.
+//
+//*****************************************************************************
+#if OS_PROFILE_CRITICAL
+#define OS_ENTERCRITICAL(){sr = SRSave(); timeIoff = OS_Time();}
+#define OS_EXITCRITICAL(){static unsigned char critSite; \
+  OS_CriticalExit(sr, timeIoff, &critSite, __FILE__, __LINE__); SRRestore(sr);}
+#else
+#define OS_ENTERCRITICAL(){sr = SRSave();}
+#define OS_EXITCRITICAL(){SRRestore(sr);}
+#endif
+
 typedef struct tcb{
   unsigned char * stackPtr;
   struct tcb * next;
+  struct tcb * prev;
   unsigned char id;
+  unsigned char * stackBase;     // lowest address of the thread's stack
   unsigned long sleepCount;
-  unsigned long priority;
+  struct tcb * sleepNext;       // sleep delta queue, apart from next and prev
+  struct tcb * sleepPrev;
+  unsigned char timedWait;      // in the delta queue for a wait timeout
+  unsigned char timedOut;       // the last timed wait ran out
+  unsigned long priority;       // current priority, raised by priority inheritance
+  unsigned long basePriority;   // priority given to OS_AddThread
+  unsigned char state;
+  struct tcb ** waitList;       // wait queue the thread is blocked on
   struct Sema4Type * BlockPt;
+  struct MutexType * MutexBlockPt;
+  struct MutexType * MutexList; // mutexes owned by the thread
+  unsigned long flagsWait;      // event flags waited for, then the ones that woke it
+  unsigned char flagsMode;      // FLAGS_ANY or FLAGS_ALL, plus FLAGS_CLEAR
+  unsigned long wakeTime;       // OS_Time when a signal made the thread ready
+  unsigned char wakePending;    // wakeTime is waiting to be measured
+  unsigned long long runTime;   // clock cycles spent running, ISRs excluded
+  unsigned long switches;       // times the thread was switched in
+  unsigned long overruns;       // OS_SleepUntil releases that had already passed
 }TCB;
 
 typedef struct Sema4Type{
   short value;
+  struct tcb * waitList;   // blocked threads, highest priority first
 }Sema4Type;
 
+typedef struct FlagsType{
+  unsigned long flags;     // set flags, one per bit
+  struct tcb * waitList;   // blocked threads, highest priority first
+}FlagsType;
+
+typedef struct MutexType{
+  struct tcb * owner;
+  struct tcb * waitList;        // blocked threads, highest priority first
+  struct MutexType * next;      // next mutex owned by the same thread
+  unsigned long inversionStart; // OS_Time when the owner's priority was raised
+  unsigned char inverted;       // owner is running at an inherited priority
+  unsigned long inversions;     // number of priority inversions bounded
+  unsigned long maxInversion;   // longest inversion in usec
+}MutexType;
+
+typedef struct FifoType{
+  unsigned long * buffer;       // storage given to OS_Fifo_Create
+  unsigned long size;           // entries in buffer
+  unsigned long count;          // entries in the FIFO
+  unsigned long putIndex;       // next entry to put
+  unsigned long getIndex;       // next entry to get
+  Sema4Type dataReady;          // entries no getter has taken yet
+  unsigned long lost;           // entries that did not fit
+}FifoType;
+
+typedef struct MsgQueueType{
+  FifoType fifo;                // message pointers, oldest first
+}MsgQueueType;
+
+typedef struct CritSiteType{
+  const char * file;            // OS_EXITCRITICAL call site
+  unsigned short line;
+  unsigned long count;          // critical sections timed
+  unsigned long max;            // longest in clock cycles
+}CritSiteType;
+
 
 //*****************************************************************************
 //
@@ -52,21 +150,50 @@ typedef struct Sema4Type{
 
 extern void OS_Init(void);
 extern int OS_AddThread(void(*task)(void), unsigned long stackSize, unsigned long priority);
+extern int OS_AddKernelThread(void(*task)(void), unsigned long stackSize, unsigned long priority);
 extern int OS_AddButtonTask(void(*task)(void), unsigned long priority);
 extern int OS_AddDownTask(void(*task)(void), unsigned long priority);
 extern int OS_AddPeriodicThread(void(*task)(void), unsigned long period, unsigned long priority);
+extern int OS_AddPeriodicThreadBudget(void(*task)(void), unsigned long period, unsigned long priority,
+                                      unsigned long budget);
+extern int OS_PeriodicSchedulable(unsigned long *loadPt, unsigned long *busyPt, unsigned long *unknownPt);
+extern long OS_JitterPercentile(int id, unsigned long permille);
+extern void OS_ClearJitter(int id);
+extern int OS_SetPeriodicPeriod(int id, unsigned long period);
 extern void OS_Launch(unsigned long period);
 extern void OS_Sleep(unsigned long period);
+extern void OS_SleepUntil(unsigned long * lastWake, unsigned long period);
+extern unsigned long OS_MsTime(void);
 extern void OS_Suspend(void);
 extern void OS_Kill(void);
 extern unsigned char OS_Id(void);
-extern void OS_Fifo_Init(unsigned int size);
+extern int OS_Fifo_Init(unsigned int size);
 extern unsigned int OS_Fifo_Get(unsigned long * dataPtr);
 extern unsigned int OS_Fifo_Put(unsigned long data);
+extern int OS_Fifo_Create(FifoType *fifoPt, unsigned long *buffer, unsigned long size);
+extern int OS_Fifo_Send(FifoType *fifoPt, unsigned long data);
+extern unsigned long OS_Fifo_SendN(FifoType *fifoPt, const unsigned long data[], unsigned long num);
+extern int OS_Fifo_Recv(FifoType *fifoPt, unsigned long *dataPtr);
+extern int OS_Fifo_TryRecv(FifoType *fifoPt, unsigned long *dataPtr);
+extern int OS_Fifo_RecvTimeout(FifoType *fifoPt, unsigned long *dataPtr, unsigned long timeout);
+extern unsigned long OS_Fifo_RecvN(FifoType *fifoPt, unsigned long data[], unsigned long max);
+extern unsigned long OS_Fifo_RecvNTimeout(FifoType *fifoPt, unsigned long data[], unsigned long max,
+                                          unsigned long timeout);
 extern void OS_MailBox_Init(void);
 extern void OS_MailBox_Send(unsigned long data);
 extern unsigned long OS_MailBox_Recv(void);
+extern int OS_MailBox_RecvTimeout(unsigned long *dataPtr, unsigned long timeout);
+extern int OS_MsgQueue_Create(MsgQueueType *queuePt, void *slots[], unsigned long size);
+extern int OS_MsgQueue_Send(MsgQueueType *queuePt, void *msgPt);
+extern void * OS_MsgQueue_Recv(MsgQueueType *queuePt);
+extern int OS_MsgQueue_RecvTimeout(MsgQueueType *queuePt, void **msgPt, unsigned long timeout);
+extern int OS_Defer(void(*work)(unsigned long), unsigned long arg);
 extern unsigned long OS_Time(void);
+extern void OS_ChargeIsr(unsigned char isrClass, unsigned long startTime);
+extern void OS_CriticalExit(long sr, unsigned long startTime, unsigned char * site, 
+                            const char * file, unsigned short line);
+extern long SRSave(void);
+extern void SRRestore(long sr);
 extern long OS_TimeDifference(unsigned long time1, unsigned long time2);
 extern void OS_DebugProfileInit(void);
 extern void OS_DebugB0Set(void);
@@ -76,8 +203,20 @@ extern void OS_DebugB1Clear(void);
 extern void OS_InitSemaphore(Sema4Type *semaPt, unsigned int value);
 extern void OS_Signal(Sema4Type *semaPt);
 extern void OS_Wait(Sema4Type *semaPt);
+extern int OS_WaitTimeout(Sema4Type *semaPt, unsigned long timeout);
 extern void OS_bSignal(Sema4Type *semaPt);
 extern void OS_bWait(Sema4Type *semaPt);
+extern int OS_bWaitTimeout(Sema4Type *semaPt, unsigned long timeout);
+extern void OS_InitFlags(FlagsType *flagsPt, unsigned long flags);
+extern void OS_SetFlags(FlagsType *flagsPt, unsigned long flags);
+extern void OS_ClearFlags(FlagsType *flagsPt, unsigned long flags);
+extern unsigned long OS_WaitFlags(FlagsType *flagsPt, unsigned long mask, unsigned char mode);
+extern unsigned long OS_WaitFlagsTimeout(FlagsType *flagsPt, unsigned long mask, unsigned char mode,
+                                         unsigned long timeout);
+extern void OS_InitMutex(MutexType *mutexPt);
+extern void OS_MutexLock(MutexType *mutexPt);
+extern int OS_MutexLockTimeout(MutexType *mutexPt, unsigned long timeout);
+extern void OS_MutexUnlock(MutexType *mutexPt);
 
 
 
@@ -14,17 +14,21 @@
 
   EXPORT  StackInit
   EXPORT  LaunchInternal
-  EXPORT  SwitchThreads
+  EXPORT  PendSVHandler
   EXPORT  TriggerPendSV
   EXPORT  SRSave
   EXPORT  SRRestore
+  EXPORT  WaitForInterrupt
 
   IMPORT  CurrentThread
   IMPORT  NextThread
+  IMPORT  OSBasePri
+  IMPORT  PendSVSchedule
 
 NVIC_INT_CTRL   EQU     0xE000ED04     ; Interrupt control state register.
 NVIC_PENDSVSET  EQU     0x10000000     ; Value to trigger PendSV exception.
 NEXT_PTR_OFFSET EQU		4
+CONTROL_SPSEL   EQU     0x00000002     ; Thread mode runs on PSP
 
 
 ThreadStkPtr	RN R0
@@ -33,21 +37,30 @@ task			RN R1
 
 ;*********************************************************************
 ;
-; Enter a critical section.  Copied from uCOSII.
+; Enter a critical section.  Raises BASEPRI to OSBasePri, which masks the
+; interrupts at OS_KERNEL_PRIORITY and below and leaves the ones above it
+; running.  BASEPRI_MAX never lowers BASEPRI, so sections nest, and an
+; ISR's section does not unmask anything.
+;
+; Returns: R0 is BASEPRI before the section, 0 if nothing was masked
 ;
 ;*********************************************************************
 SRSave
-  MRS	R0, PRIMASK
-  CPSID I
+  MRS	R0, BASEPRI
+  LDR	R1, =OSBasePri
+  LDR	R1, [R1]
+  MSR	BASEPRI_MAX, R1
   BX  	LR
 
 ;*********************************************************************
 ;
-; Exit a critical section.  Copied from uCOSII.
+; Exit a critical section.
+;
+; R0 is the first parameter, BASEPRI returned by SRSave
 ;
 ;*********************************************************************
 SRRestore
-  MSR  PRIMASK, R0
+  MSR	BASEPRI, R0
   BX	LR
 
 ;*********************************************************************
@@ -59,10 +72,15 @@ SRRestore
 ;
 ; Returns: R0 is the new position of the stack pointer
 ;
+; Interrupts are disabled while SP points at the new stack, and PRIMASK
+; is put back as it was, so a thread added before OS_Launch does not
+; enable the interrupts OS_Init disabled.
+;
 ; Written by Katy Loeffler
 ;
 ;*********************************************************************
 StackInit
+  MRS	R3, PRIMASK			; R3 keeps the caller's PRIMASK
   CPSID	I
   PUSH  {R4}				; We'll use R4 for manipulation
   MOV	R2, R13				; Save current stack pointer in R2
@@ -97,23 +115,21 @@ StackInit
   MOV	R4, #0x06060606		
   PUSH 	{R4}				; Fake R6
   MOV	R4, #0x05050505		
-  PUSH 	{R4}				; Fake R15
+  PUSH 	{R4}				; Fake R5
   MOV	R4, #0x04040404		
   PUSH 	{R4}				; Fake R4
-  MOV	R4, #0xFFFFFFF9		
-  PUSH 	{R4}				; Push LR value onto stack tell the processor
-  							; to enter thread mode the first time the thread
-							; is accessed.
 
   MOV 	R0, R13				; Return the new ThreadSP
   MOV 	R13, R2				; Restore the current SP
   POP	{R4}			    ; Restore R4
-  CPSIE	I
+  MSR	PRIMASK, R3
   BX LR
 
 ;******************************************************************************
 ;
-; Launch the operating system. 
+; Launch the operating system.  Threads run on PSP and every exception
+; runs on MSP, the startup stack, so thread stacks only hold what the
+; thread itself needs.
 ;
 ; R0 is the first parameter, holds the SP of the first thread to be executed.
 ;
@@ -121,54 +137,75 @@ StackInit
 ;******************************************************************************
 LaunchInternal
   ;CPSID I
-  MOV 	R13, R0						; Load thread SP
-  POP	{LR}
-  POP	{R4,R5,R6,R7,R8,R9,R10,R11}	; Pop registers for new thread
+  LDMIA	R0!, {R4-R11}				; Pop registers for new thread
+  MSR	PSP, R0						; Thread stack is the exception frame
+  MOV	R0, #CONTROL_SPSEL
+  MSR	CONTROL, R0					; Switch thread mode to PSP
+  ISB
   POP	{R0-R3,R12}
   POP	{LR}						; Throw away
-  POP	{LR}						; LR = PC					
+  POP	{LR}						; LR = PC
+  ADD	R13, R13, #4				; Throw away the PSR
   CPSIE I
   BX	LR
 
 
 ;******************************************************************************
 ;
-; Switch Threads: Push R4-R11 on the stack and save the SP of the old thread
-; in the TCB, then restore the SP of the new thread and pop R4-R11.
+; PendSV handler, switches threads.  PendSVSchedule picks NextThread, then
+; R4-R11 of the old thread are pushed on its PSP and the SP is saved in
+; the TCB, then the SP of the new thread is restored and R4-R11 popped.
+; The exception return pops the rest of the new thread's registers.
+; The swap runs at OSBasePri, so interrupts above OS_KERNEL_PRIORITY
+; are not delayed by it.
 ;
 ; Input: none
 ;
-; Returns: R0 is the SP of the outgoing thread to be saved in the TCB
-; Written by Katy Loeffler
+; Returns: none
 ;
 ;******************************************************************************
-SwitchThreads
-  CPSID I
+PendSVHandler
+  PUSH	{R0, LR}					; Keep EXC_RETURN, R0 keeps MSP 8 byte aligned
+  BL	PendSVSchedule
+  POP	{R0, LR}
+  MRS	R3, BASEPRI					; R3 keeps BASEPRI
+  LDR	R1, =OSBasePri
+  LDR	R1, [R1]
+  MSR	BASEPRI_MAX, R1
+  MRS	R0, PSP
+  STMDB	R0!, {R4-R11}				; Push registers for old thread
   LDR	R1, =CurrentThread
-  LDR   R0,[R1]						
-  PUSH 	{R11,R10,R9,R8,R7,R6,R5,R4}	; Push registers for old thread
-  PUSH	{LR}
-  STR	R13,[R0]			 		; Save new SP in TCB, it is the first entry
-  LDR   R0, =NextThread
-  LDR   R0,[R0]						; Dereference
-  STR	R0,[R1]
-  LDR	R13,[R0]					; Get stack pointer
-  POP	{LR}
-  POP	{R4,R5,R6,R7,R8,R9,R10,R11}	; Pop registers for new thread   
-  CPSIE I
+  LDR   R2,[R1]
+  STR	R0,[R2]						; Save SP in TCB, it is the first entry
+  LDR   R2, =NextThread
+  LDR   R2,[R2]						; Dereference
+  STR	R2,[R1]
+  LDR	R0,[R2]						; Get stack pointer
+  LDMIA	R0!, {R4-R11}				; Pop registers for new thread
+  MSR	PSP, R0
+  MSR	BASEPRI, R3
   BX	LR
 	
 ;******************************************************************************
 ;
 ; Trigger a PendSV exception.  This function was copied from uOSII.
+; It leaves PRIMASK and BASEPRI as they were, so the switch waits until
+; the caller's critical section ends.
 ;
 ;******************************************************************************
 TriggerPendSV
-	CPSID  	I
     LDR     R0, =NVIC_INT_CTRL ; Trigger the PendSV exception (causes context switch)
     LDR     R1, =NVIC_PENDSVSET
     STR     R1, [R0]
-	CPSIE	I
+    BX      LR
+
+;******************************************************************************
+;
+; Sleep the core until an interrupt comes in, for the idle thread.
+;
+;******************************************************************************
+WaitForInterrupt
+    WFI
     BX      LR
 
 ;******************************************************************************
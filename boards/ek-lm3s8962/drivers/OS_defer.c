@@ -0,0 +1,184 @@
+//*****************************************************************************
+//
+// Filename: OS_defer.c
+// Description: Job queues and the deferred work queue.
+//
+// A job queue is a ring of jobs, each a function and its argument, and a
+// semaphore that counts the jobs no thread has taken yet.  JobQueue_Put
+// does not block, so ISRs may post jobs, and every thread that serves the
+// queue loops in JobQueue_Run.  The deferred work thread below and the
+// worker pool in OS_worker.c are both built on one.
+//
+// An ISR that has more to do than acknowledge its hardware posts the
+// rest as a work item with OS_Defer and returns.  The items run in order
+// in a kernel thread at DEFER_PRIORITY, so they run as soon as the last
+// ISR returns, can be preempted by any interrupt, and show up in the
+// thread statistics instead of as ISR time.  No user thread runs at
+// DEFER_PRIORITY, so a busy one cannot hold them up.
+//
+// A work item runs in a thread, so it may call anything a thread may,
+// but it must not block for long since it holds up the items behind it.
+//
+//*****************************************************************************
+
+#include "drivers/OS.h"
+#include "drivers/OS_defer.h"
+
+//***********************************************************************
+//
+// Global Variables
+//
+//***********************************************************************
+JobType DeferJobs[DEFER_QUEUE_SIZE];
+JobQueueType DeferQueue;
+
+long SRSave (void);
+void SRRestore(long sr);
+
+//***********************************************************************
+//
+// JobQueue_Init empties a job queue and clears its statistics.
+//
+// \param queuePt is the queue.
+// \param jobs is the ring the queue keeps its jobs in.
+// \param size is the number of jobs in \param jobs.
+// \return none.
+//
+//***********************************************************************
+void
+JobQueue_Init(JobQueueType *queuePt, JobType *jobs, unsigned long size)
+{
+  queuePt->jobs = jobs;
+  queuePt->size = size;
+  queuePt->put = 0;
+  queuePt->get = 0;
+  queuePt->count = 0;
+  queuePt->busy = 0;
+  queuePt->maxBusy = 0;
+  queuePt->run = 0;
+  queuePt->lost = 0;
+  queuePt->max = 0;
+  OS_InitSemaphore(&(queuePt->ready), 0);
+}
+
+//***********************************************************************
+//
+// JobQueue_Put queues a job for the next thread that serves the queue.
+// Does not block, so it may be called from an ISR.
+//
+// \param queuePt is the queue.
+// \param job is the function to run.
+// \param arg is passed to \param job.
+//
+// \return SUCCESS, or FAIL if the queue is full and the job was dropped.
+//
+//***********************************************************************
+int
+JobQueue_Put(JobQueueType *queuePt, void(*job)(unsigned long), unsigned long arg)
+{
+  long sr;
+  unsigned long timeIoff;
+
+  OS_ENTERCRITICAL();
+  if(queuePt->count == queuePt->size)
+  {
+    (queuePt->lost)++;
+    OS_EXITCRITICAL();
+    return FAIL;
+  }
+  queuePt->jobs[queuePt->put].job = job;
+  queuePt->jobs[queuePt->put].arg = arg;
+  queuePt->put = (queuePt->put + 1) % queuePt->size;
+  (queuePt->count)++;
+  if(queuePt->count > queuePt->max)
+  {
+    queuePt->max = queuePt->count;
+  }
+  OS_EXITCRITICAL();
+
+  OS_Signal(&(queuePt->ready));
+  return SUCCESS;
+}
+
+//***********************************************************************
+//
+// JobQueue_Run waits for the oldest job on a queue and runs it.  Any
+// number of threads may serve the same queue.
+//
+// \param queuePt is the queue.
+// \return none.
+//
+//***********************************************************************
+void
+JobQueue_Run(JobQueueType *queuePt)
+{
+  JobType job;
+  long sr;
+  unsigned long timeIoff;
+
+  OS_Wait(&(queuePt->ready));
+  OS_ENTERCRITICAL();
+  job = queuePt->jobs[queuePt->get];
+  queuePt->get = (queuePt->get + 1) % queuePt->size;
+  (queuePt->count)--;
+  (queuePt->busy)++;
+  if(queuePt->busy > queuePt->maxBusy)
+  {
+    queuePt->maxBusy = queuePt->busy;
+  }
+  OS_EXITCRITICAL();
+
+  job.job(job.arg);
+
+  OS_ENTERCRITICAL();
+  (queuePt->busy)--;
+  (queuePt->run)++;
+  OS_EXITCRITICAL();
+}
+
+//***********************************************************************
+//
+// DeferThread runs the work items one at a time, oldest first.
+//
+//***********************************************************************
+static void
+DeferThread(void)
+{
+  for(;;)
+  {
+    JobQueue_Run(&DeferQueue);
+  }
+}
+
+//***********************************************************************
+//
+// Defer_Init empties the queue and starts the thread that runs it.
+// Called by OS_Init.
+//
+// \param none.
+// \return none.
+//
+//***********************************************************************
+void
+Defer_Init(void)
+{
+  JobQueue_Init(&DeferQueue, DeferJobs, DEFER_QUEUE_SIZE);
+  OS_AddKernelThread(&DeferThread, DEFER_STACK_SIZE, DEFER_PRIORITY);
+}
+
+//***********************************************************************
+//
+// OS_Defer queues work to run in the deferred work thread.  Does not
+// block, so it may be called from an ISR.
+//
+// \param work is the function to run.
+// \param arg is passed to \param work.
+//
+// \return SUCCESS, or FAIL if the queue is full and the work was dropped.
+//
+//***********************************************************************
+int
+OS_Defer(void(*work)(unsigned long), unsigned long arg)
+{
+  return JobQueue_Put(&DeferQueue, work, arg);
+}
@@ -0,0 +1,38 @@
+//*****************************************************************************
+//
+// OS_defer.h contains the job queue that the deferred work thread and the
+// worker pool are built on, and the deferred work queue that ISRs hand
+// their slow work to.  drivers/OS.h must be included first.
+//
+//*****************************************************************************
+
+#define DEFER_QUEUE_SIZE 32			// work items waiting to run
+#define DEFER_PRIORITY 0			// priority of the thread that runs them, above
+									// every user thread, see OS_USER_PRIORITY
+#define DEFER_STACK_SIZE 512		// bytes, button tasks run on this stack
+
+typedef struct JobType{
+  void(*job)(unsigned long);
+  unsigned long arg;
+}JobType;
+
+typedef struct JobQueueType{
+  JobType * jobs;               // ring of size jobs
+  unsigned long size;
+  unsigned long put;            // next job to put
+  unsigned long get;            // next job to run
+  unsigned long count;          // jobs waiting
+  Sema4Type ready;              // jobs no thread has taken yet
+  unsigned long busy;           // threads running a job now
+  unsigned long maxBusy;        // most threads running a job at once
+  unsigned long run;            // jobs finished
+  unsigned long lost;           // jobs that did not fit
+  unsigned long max;            // most jobs waiting at once
+}JobQueueType;
+
+extern JobQueueType DeferQueue;     // work items for the deferred work thread
+
+extern void JobQueue_Init(JobQueueType *queuePt, JobType *jobs, unsigned long size);
+extern int JobQueue_Put(JobQueueType *queuePt, void(*job)(unsigned long), unsigned long arg);
+extern void JobQueue_Run(JobQueueType *queuePt);
+extern void Defer_Init(void);
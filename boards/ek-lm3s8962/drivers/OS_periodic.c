@@ -0,0 +1,608 @@
+//*****************************************************************************
+//
+// Filename: OS_periodic.c
+// Description: Timer service for periodic threads.  Any number (up to
+// MAX_PERIODIC_THREADS) of periodic tasks share GPTimer3A, which runs as
+// a 32-bit one-shot timer programmed for the next release.  The tasks
+// are kept in a min-heap ordered by release time, so finding the next
+// task is O(1) and rescheduling one is O(log n).  Tasks that are due at
+// the same time run in priority order.
+//
+// Release times are kept in OS_Time cycles, which count up on the system
+// timebase, so a release is never delayed by the time it took to run the
+// tasks before it.  Periods must be under 2^31 cycles.
+//
+// The tasks run in the Timer3A ISR, at the NVIC priority of the highest
+// priority periodic thread, but no higher than OS_KERNEL_PRIORITY since
+// the tasks call the OS.
+//
+// The run time of every task is measured on each release and the longest
+// is kept as its WCET.  A task added with OS_AddPeriodicThreadBudget
+// gives its own estimate, and the larger of the two is its cost.  Since
+// the tasks run one after another in the same ISR, a task released while
+// others are due waits for all of them.  Every task meets its deadline
+// (its next release) if the sum of the costs is no longer than the
+// shortest period.  OS_AddPeriodicThreadBudget runs this test with the new
+// task included, see PERIODIC_ADMISSION.  OS_AddPeriodicThread gives no
+// budget, so the new task's cost counts as 0 until it has run, and it is
+// never rejected for its own cost.
+//
+// Every release also records the jitter of the task, the time from its
+// last start less its period, in raw cycles in a histogram of
+// JITTER_BINS bins of 2^JITTER_SHIFT cycles, and counts the releases it
+// missed.  The ISR only shifts and counts, OS_JitterPercentile reads the
+// percentiles from the histogram when asked.
+//
+//*****************************************************************************
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/timer.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "drivers/OS.h"
+#include "drivers/OS_periodic.h"
+#include "drivers/OS_trace.h"
+#include "string.h"
+
+//***********************************************************************
+//
+// Global Variables
+//
+//***********************************************************************
+PeriodicTaskType PeriodicTasks[MAX_PERIODIC_THREADS];
+unsigned char PeriodicHeap[MAX_PERIODIC_THREADS];  // ids, earliest release first
+int NumPeriodic;
+unsigned long PeriodicPriority;  // NVIC priority of Timer3A
+unsigned long PeriodicUnschedulable;
+
+extern unsigned long IsrCycles;   // clock cycles spent in all ISRs, in OS.c
+
+long SRSave (void);
+void SRRestore(long sr);
+
+//***********************************************************************
+//
+// Earlier returns true if periodic task a should run before task b.
+//
+//***********************************************************************
+static int
+Earlier(unsigned char a, unsigned char b)
+{
+  long diff = (long)(PeriodicTasks[a].deadline - PeriodicTasks[b].deadline);
+
+  if(diff != 0)
+  {
+    return diff < 0;
+  }
+  return PeriodicTasks[a].priority < PeriodicTasks[b].priority;
+}
+
+//***********************************************************************
+//
+// SiftUp and SiftDown restore the heap order after the entry at index
+// moves earlier or later.
+//
+//***********************************************************************
+static void
+SiftUp(int index)
+{
+  unsigned char id = PeriodicHeap[index];
+  int parent;
+
+  while(index > 0)
+  {
+    parent = (index-1)/2;
+    if(!Earlier(id, PeriodicHeap[parent]))
+    {
+      break;
+    }
+    PeriodicHeap[index] = PeriodicHeap[parent];
+    index = parent;
+  }
+  PeriodicHeap[index] = id;
+}
+
+static void
+SiftDown(int index)
+{
+  unsigned char id = PeriodicHeap[index];
+  int child;
+
+  while((child = 2*index+1) < NumPeriodic)
+  {
+    if((child+1 < NumPeriodic) && Earlier(PeriodicHeap[child+1], PeriodicHeap[child]))
+    {
+      child++;
+    }
+    if(!Earlier(PeriodicHeap[child], id))
+    {
+      break;
+    }
+    PeriodicHeap[index] = PeriodicHeap[child];
+    index = child;
+  }
+  PeriodicHeap[index] = id;
+}
+
+//***********************************************************************
+//
+// ArmTimer starts Timer3A as a one-shot for the earliest release.
+//
+//***********************************************************************
+static void
+ArmTimer(unsigned long now)
+{
+  long interval = (long)(PeriodicTasks[PeriodicHeap[0]].deadline - now);
+
+  if(interval < PERIODIC_MIN_INTERVAL)
+  {
+    interval = PERIODIC_MIN_INTERVAL;
+  }
+  TimerDisable(TIMER3_BASE, TIMER_A);
+  TimerLoadSet(TIMER3_BASE, TIMER_A, (unsigned long)interval);
+  TimerEnable(TIMER3_BASE, TIMER_A);
+}
+
+//***********************************************************************
+//
+// Jitter records the time between two starts of a task, minus its
+// period, in the task's histogram.  Not after a missed release, when
+// the last start is more than a period back.
+//
+//***********************************************************************
+static void
+Jitter(PeriodicTaskType * taskPt, unsigned long thisTime)
+{
+  long jitter;
+  unsigned long index;
+  JitterType * jitterPt = &taskPt->jitter;
+
+  if(taskPt->first)
+  {
+    return;
+  }
+  jitter = (long)(thisTime - taskPt->lastStart - taskPt->period);
+  if(jitter > jitterPt->max)
+  {
+    jitterPt->max = jitter;
+  }
+  if(jitter < jitterPt->min)
+  {
+    jitterPt->min = jitter;
+  }
+  jitter += JITTER_OFFSET;
+  index = (jitter < 0) ? 0 : ((unsigned long)jitter >> JITTER_SHIFT);
+  if(index >= JITTER_BINS)
+  {
+    index = JITTER_BINS-1;
+  }
+  jitterPt->histogram[index]++;
+  jitterPt->count++;
+}
+
+//***********************************************************************
+//
+// ClearJitter empties the jitter statistics of a task.
+//
+//***********************************************************************
+static void
+ClearJitter(JitterType * jitterPt)
+{
+  memset(jitterPt, 0, sizeof(JitterType));
+  jitterPt->min = 0x7FFFFFFF;
+  jitterPt->max = -0x7FFFFFFF;
+}
+
+//***********************************************************************
+//
+// Load returns cost/period in 0.1%, cost must be less than period.
+//
+//***********************************************************************
+static unsigned long
+Load(unsigned long cost, unsigned long period)
+{
+  if(cost < 0xFFFFFFFF/1000)
+  {
+    return (cost*1000)/period;
+  }
+  return cost/(period/1000);
+}
+
+//***********************************************************************
+//
+// Schedulable runs the schedulability test on the periodic tasks, plus
+// one more task if \param period is not 0.  The tasks all run in the
+// Timer3A ISR and none preempts another, so the worst case is every task
+// released at once and the last one waiting for all the others.  That
+// takes the sum of the costs.  If the sum is no longer than the shortest
+// period, no task is released a second time before it is done, and each
+// one finishes before its next release.
+//
+// The test is pessimistic.  Each task's first release is one period after
+// it was added, so tasks whose releases never fall in the same ISR entry
+// can fail it and still meet every deadline.  The phases drift with the
+// time of each add, so the test does not rely on them.
+//
+// A task with no budget that has not run yet has a cost of 0 here.
+//
+// \param cost is the cost of the extra task in cycles.
+// \param period is the period of the extra task in cycles, 0 for none.
+// \param loadPt is set to the total utilization in 0.1%.
+// \param busyPt is set to the sum of the costs in cycles.
+// \param unknownPt is set to the number of tasks with a cost of 0.
+//
+// \return SUCCESS if every task meets its deadline, else FAIL.
+//
+//***********************************************************************
+static int
+Schedulable(unsigned long cost, unsigned long period, unsigned long *loadPt,
+            unsigned long *busyPt, unsigned long *unknownPt)
+{
+  unsigned long costs[MAX_PERIODIC_THREADS+1];
+  unsigned long periods[MAX_PERIODIC_THREADS+1];
+  unsigned long load = 0, busy = 0, unknown = 0, minPeriod = 0x80000000;
+  int i, n = 0;
+
+  for(i = 0; i < NumPeriodic; i++)
+  {
+    costs[n] = PeriodicTasks[i].budget;
+    if(PeriodicTasks[i].wcet > costs[n])
+    {
+      costs[n] = PeriodicTasks[i].wcet;
+    }
+    periods[n++] = PeriodicTasks[i].period;
+  }
+  if(period != 0)
+  {
+    costs[n] = cost;
+    periods[n++] = period;
+  }
+
+  for(i = 0; i < n; i++)
+  {
+    if(costs[i] == 0)
+    {
+      unknown++;
+    }
+  }
+  *unknownPt = unknown;
+
+  for(i = 0; i < n; i++)
+  {
+    if(costs[i] >= periods[i])
+    {
+      *loadPt = 1000;
+      *busyPt = 0xFFFFFFFF;
+      return FAIL;
+    }
+    load += Load(costs[i], periods[i]);
+    busy = (costs[i] > 0xFFFFFFFF - busy) ? 0xFFFFFFFF : busy + costs[i];
+    if(periods[i] < minPeriod)
+    {
+      minPeriod = periods[i];
+    }
+  }
+  *loadPt = load;
+  *busyPt = busy;
+
+  // One ISR runs the tasks back to back, so all of them released at once
+  // must fit in the shortest period
+  return (busy <= minPeriod) ? SUCCESS : FAIL;
+}
+
+//***********************************************************************
+//
+// Periodic_Init empties the timer service and sets up GPTimer3A as a
+// 32-bit one-shot timer.
+//
+// \param none.
+// \return none.
+//
+//***********************************************************************
+void
+Periodic_Init(void)
+{
+  NumPeriodic = 0;
+  PeriodicPriority = 7;
+  PeriodicUnschedulable = 0;
+
+  SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER3);
+  TimerDisable(TIMER3_BASE, TIMER_A);
+  TimerConfigure(TIMER3_BASE, TIMER_CFG_32_BIT_OS);
+  TimerIntClear(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
+  TimerIntEnable(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
+}
+
+//***********************************************************************
+//
+// OS_AddPeriodicThread adds a task to the timer service.  The first
+// release is one period from now.  Its cost is not known until it has
+// run, so it is added with a budget of 0.  The schedulability test then
+// only checks the costs of the tasks already added against the shortest
+// period, and never rejects the new task for its own cost.  Use
+// OS_AddPeriodicThreadBudget for that.  OS_PeriodicSchedulable counts
+// the tasks whose cost is still unknown.
+//
+// \param task is a pointer to the function to be executed at a periodic rate
+// \param period is the period in clock cycles (20ns)
+// \param priority is the priority of the task, 0 to 7.  The timer ISR runs
+// at the highest priority of all the periodic threads, and tasks that are
+// due at the same time run in priority order.
+//
+// \return the ID of the periodic thread plus one, FAIL if there is no room,
+// \param period or \param priority is out of acceptable range, or the
+// tasks would miss deadlines and PERIODIC_ADMISSION is 1.
+//
+//***********************************************************************
+int
+OS_AddPeriodicThread(void(*task)(void), unsigned long period, unsigned long priority)
+{
+  return OS_AddPeriodicThreadBudget(task, period, priority, 0);
+}
+
+//***********************************************************************
+//
+// OS_AddPeriodicThreadBudget adds a task to the timer service like
+// OS_AddPeriodicThread, and checks that its deadlines and those of the
+// tasks already added are met if it runs for \param budget each release.
+//
+// \param task is a pointer to the function to be executed at a periodic rate
+// \param period is the period in clock cycles (20ns)
+// \param priority is the priority of the task, 0 to 7.
+// \param budget is the longest the task is expected to run, in clock
+// cycles.  0 means unknown, as in OS_AddPeriodicThread.
+//
+// \return the ID of the periodic thread plus one, or FAIL.
+//
+//***********************************************************************
+int
+OS_AddPeriodicThreadBudget(void(*task)(void), unsigned long period, unsigned long priority,
+                           unsigned long budget)
+{
+  int id;
+  long sr;
+  unsigned long timeIoff;
+  unsigned long load, busy, unknown;
+
+  if((priority > 7) || (period < PERIODIC_MIN_INTERVAL) || (period >= 0x80000000))
+  {
+    return FAIL;
+  }
+  if((NumPeriodic < MAX_PERIODIC_THREADS) && !Schedulable(budget, period, &load, &busy, &unknown))
+  {
+    PeriodicUnschedulable++;
+    if(PERIODIC_ADMISSION)
+    {
+      return FAIL;
+    }
+  }
+  OS_ENTERCRITICAL();
+  if(NumPeriodic >= MAX_PERIODIC_THREADS)
+  {
+    OS_EXITCRITICAL();
+    return FAIL;
+  }
+
+  id = NumPeriodic;
+  PeriodicTasks[id].task = task;
+  PeriodicTasks[id].period = period;
+  PeriodicTasks[id].priority = priority;
+  PeriodicTasks[id].deadline = OS_Time() + period;
+  PeriodicTasks[id].first = 1;
+  PeriodicTasks[id].budget = budget;
+  PeriodicTasks[id].wcet = 0;
+  ClearJitter(&PeriodicTasks[id].jitter);
+  PeriodicHeap[NumPeriodic] = (unsigned char)id;
+  NumPeriodic++;
+  SiftUp(NumPeriodic-1);
+
+  // The ISR runs at the highest priority of any periodic thread
+  if(priority < PeriodicPriority || NumPeriodic == 1)
+  {
+    PeriodicPriority = priority;
+    if(priority < OS_KERNEL_PRIORITY)
+    {
+      priority = OS_KERNEL_PRIORITY;
+    }
+    IntPrioritySet(INT_TIMER3A,(((unsigned char)priority)<<5)&0xF0);
+  }
+  ArmTimer(OS_Time());
+  IntEnable(INT_TIMER3A);
+
+  OS_EXITCRITICAL();
+  return id+1;
+}
+
+//***********************************************************************
+//
+// OS_PeriodicSchedulable runs the schedulability test on the periodic
+// tasks with the costs measured so far.  A task whose run time grew after
+// it was added is only caught here.
+//
+// \param loadPt is set to the utilization of the tasks in 0.1%.
+// \param busyPt is set to the sum of the costs in clock cycles, the
+// longest the timer ISR runs.
+// \param unknownPt is set to the number of tasks added without a budget
+// that have not run yet.  Their cost counts as 0, so SUCCESS does not
+// cover them.
+//
+// \return SUCCESS if every task meets its deadline, else FAIL.
+//
+//***********************************************************************
+int
+OS_PeriodicSchedulable(unsigned long *loadPt, unsigned long *busyPt, unsigned long *unknownPt)
+{
+  return Schedulable(0, 0, loadPt, busyPt, unknownPt);
+}
+
+//***********************************************************************
+//
+// OS_JitterPercentile finds the jitter of a periodic thread that the
+// given share of its releases did not exceed.  Reads the histogram, so
+// the answer is the top of a bin, and is clamped to the smallest and
+// largest jitter seen.
+//
+// \param id is the value returned by OS_AddPeriodicThread.
+// \param permille is the share of releases in 0.1%, 500 for the median,
+// 990 for p99 and 999 for p99.9.
+//
+// \return the jitter in clock cycles, 0 if \param id is not valid or the
+// thread has no jitter recorded yet.
+//
+//***********************************************************************
+long
+OS_JitterPercentile(int id, unsigned long permille)
+{
+  JitterType * jitterPt;
+  unsigned long count, rank, seen = 0;
+  long value;
+  int i;
+
+  if((id < 1) || (id > NumPeriodic) || (permille > 1000))
+  {
+    return 0;
+  }
+  jitterPt = &PeriodicTasks[id-1].jitter;
+  count = jitterPt->count;
+  if(count == 0)
+  {
+    return 0;
+  }
+
+  // rank = ceil(count*permille/1000) without overflowing count*permille
+  rank = count - ((count/1000)*(1000-permille) + ((count%1000)*(1000-permille))/1000);
+  for(i = 0; i < JITTER_BINS-1; i++)
+  {
+    seen += jitterPt->histogram[i];
+    if(seen >= rank)
+    {
+      break;
+    }
+  }
+  if(i == JITTER_BINS-1)
+  {
+    return jitterPt->max;
+  }
+  value = (long)((i+1) << JITTER_SHIFT) - JITTER_OFFSET - 1;
+  if(value < jitterPt->min)
+  {
+    return jitterPt->min;
+  }
+  if(value > jitterPt->max)
+  {
+    return jitterPt->max;
+  }
+  return value;
+}
+
+//***********************************************************************
+//
+// OS_ClearJitter starts the jitter statistics of a periodic thread over.
+//
+// \param id is the value returned by OS_AddPeriodicThread.
+//
+// \return none.
+//
+//***********************************************************************
+void
+OS_ClearJitter(int id)
+{
+  long sr;
+  unsigned long timeIoff;
+
+  if((id < 1) || (id > NumPeriodic))
+  {
+    return;
+  }
+  OS_ENTERCRITICAL();
+  ClearJitter(&PeriodicTasks[id-1].jitter);
+  PeriodicTasks[id-1].first = 1;
+  OS_EXITCRITICAL();
+}
+
+//***********************************************************************
+//
+// OS_SetPeriodicPeriod changes the period of a periodic thread.  The new
+// period starts at the thread's next release, so a task may call this
+// on itself.
+//
+// \param id is the value returned by OS_AddPeriodicThread.
+// \param period is the new period in clock cycles (20ns).
+//
+// \return SUCCESS, or FAIL if \param id or \param period is not valid.
+//
+//***********************************************************************
+int
+OS_SetPeriodicPeriod(int id, unsigned long period)
+{
+  if((id < 1) || (id > NumPeriodic) || (period < PERIODIC_MIN_INTERVAL) || (period >= 0x80000000))
+  {
+    return FAIL;
+  }
+  PeriodicTasks[id-1].period = period;
+  return SUCCESS;
+}
+
+//***********************************************************************
+//
+// Timer 3A Interrupt handler, runs every periodic task that is due and
+// sets the timer for the next release.  A task that overruns its period
+// loses the releases it missed rather than running them back to back,
+// and counts them as misses.  Keeps the longest run time and the jitter
+// of each task.  The run time leaves out the ISRs that preempted the
+// task, as a thread's run time does.
+//
+//***********************************************************************
+void
+Timer3AIntHandler(void)
+{
+  unsigned char id;
+  unsigned long now, taskStart, isrStart, runTime;
+  PeriodicTaskType * taskPt;
+  unsigned long startTime = OS_Time();
+
+  Trace_Event(TRACE_ISR_ENTER, ISR_PERIODIC, 0);
+  TimerIntClear(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
+  now = startTime;
+
+  while((long)(PeriodicTasks[PeriodicHeap[0]].deadline - now) < PERIODIC_MIN_INTERVAL)
+  {
+    id = PeriodicHeap[0];
+    taskPt = &PeriodicTasks[id];
+
+    Trace_Event(TRACE_PERIODIC_START, id, 0);
+    Jitter(taskPt, now);
+    taskPt->lastStart = now;
+    taskPt->first = 0;
+
+    // Execute the periodic thread
+    taskStart = OS_Time();
+    isrStart = IsrCycles;
+    taskPt->task();
+    now = OS_Time();
+    runTime = (now - taskStart) - (IsrCycles - isrStart);
+    if(runTime > taskPt->wcet)
+    {
+      taskPt->wcet = runTime;
+    }
+
+    Trace_Event(TRACE_PERIODIC_END, id, 0);
+
+    // Schedule the next release, skipping any that were missed
+    taskPt->deadline += taskPt->period;
+    while((long)(taskPt->deadline - now) <= 0)
+    {
+      taskPt->deadline += taskPt->period;
+      taskPt->jitter.misses++;
+      taskPt->first = 1;
+    }
+    SiftDown(0);
+  }
+
+  ArmTimer(now);
+  OS_ChargeIsr(ISR_PERIODIC, startTime);
+}
+
+//******************************EOF**************************************
@@ -0,0 +1,41 @@
+//*****************************************************************************
+//
+// OS_periodic.h contains the timer service that runs all of the periodic
+// threads from GPTimer3.  drivers/OS.h must be included first.
+//
+//*****************************************************************************
+
+#define MAX_PERIODIC_THREADS 16		// periodic threads sharing GPTimer3
+#define PERIODIC_MIN_INTERVAL 100 	// tasks due this close (cycles) run now
+#define PERIODIC_ADMISSION 1		// 1: reject a task that fails the schedulability
+									// test, 0: add it and count it in PeriodicUnschedulable
+#define JITTER_BINS 32				// jitter histogram bins per periodic thread
+#define JITTER_SHIFT 6				// bin width is 2^JITTER_SHIFT cycles, 1.28 us
+#define JITTER_OFFSET ((JITTER_BINS/2) << JITTER_SHIFT)  // jitter of the first bin,
+									// negated, the end bins hold the rest
+
+typedef struct JitterType{
+  unsigned long count;          // releases measured
+  unsigned long misses;         // releases skipped because the task was late
+  long min;                     // cycles from the last start, minus the period
+  long max;
+  unsigned long histogram[JITTER_BINS];
+}JitterType;
+
+typedef struct PeriodicTaskType{
+  void(*task)(void);
+  unsigned long period;         // in clock cycles (20ns)
+  unsigned long deadline;       // next release, in OS_Time cycles
+  unsigned long priority;
+  unsigned long lastStart;      // OS_Time of the last release
+  unsigned char first;          // no jitter on the first release
+  unsigned long budget;         // run time given when added, in cycles
+  unsigned long wcet;           // longest measured run time, in cycles
+  JitterType jitter;
+}PeriodicTaskType;
+
+extern PeriodicTaskType PeriodicTasks[MAX_PERIODIC_THREADS];
+extern int NumPeriodic;
+extern unsigned long PeriodicUnschedulable;  // tasks added that failed the test
+
+extern void Periodic_Init(void);
@@ -0,0 +1,152 @@
+//*****************************************************************************
+//
+// Filename: OS_pool.c
+// Description: Fixed-block memory pools.  A pool hands out blocks of one
+// size from storage the caller gives it, so a buffer that is only needed
+// now and then does not have to sit in RAM as a static array for good.
+// Free blocks are kept on a list threaded through the blocks themselves,
+// so alloc and free are O(1) and a pool costs no RAM beyond its storage
+// and its PoolType.
+//
+// Every call runs in a critical section, so threads and ISRs may share
+// a pool.  OS_Pool_Alloc never blocks, it returns NULL when the pool is
+// empty.
+//
+// Each pool counts how many of its blocks are out now and at most, and
+// how often it ran out, so a pool can be sized from a run of the real
+// program (see the Pools command in the interpreter).
+//
+//*****************************************************************************
+
+#include "drivers/OS.h"
+#include "drivers/OS_pool.h"
+#include "string.h"
+
+//***********************************************************************
+//
+// Global Variables
+//
+//***********************************************************************
+PoolType * Pools;        // every pool created, newest first
+
+long SRSave (void);
+void SRRestore(long sr);
+
+//***********************************************************************
+//
+// OS_Pool_Create makes a pool of free blocks out of storage.  A pool is
+// created once, before the threads or ISRs that use it start.
+//
+// \param poolPt is the pool.
+// \param name is shown by the Pools command, it is not copied.
+// \param storage holds the blocks, owned by the pool from now on.  It
+// must be word aligned and at least POOL_WORDS(blockSize, numBlocks)
+// unsigned longs.
+// \param blockSize is the size of a block in bytes, rounded up to a
+// multiple of 4.
+// \param numBlocks is the number of blocks.
+//
+// \return SUCCESS, or FAIL if storage is NULL or either size is 0.
+//
+//***********************************************************************
+int
+OS_Pool_Create(PoolType *poolPt, const char *name, void *storage,
+               unsigned long blockSize, unsigned long numBlocks)
+{
+  unsigned long words = (blockSize + sizeof(unsigned long) - 1)/sizeof(unsigned long);
+  unsigned long * block = (unsigned long *)storage;
+  unsigned long i;
+  long sr;
+  unsigned long timeIoff;
+
+  if((storage == NULL) || (blockSize == 0) || (numBlocks == 0))
+  {
+    return FAIL;
+  }
+  // Thread the free list through the blocks, in address order
+  for(i = 0; i < numBlocks - 1; i++)
+  {
+    *(void **)&block[i*words] = &block[(i+1)*words];
+  }
+  *(void **)&block[i*words] = NULL;
+
+  poolPt->freeList = storage;
+  poolPt->blockSize = words*sizeof(unsigned long);
+  poolPt->numBlocks = numBlocks;
+  poolPt->used = 0;
+  poolPt->maxUsed = 0;
+  poolPt->allocs = 0;
+  poolPt->fails = 0;
+  poolPt->name = name;
+
+  OS_ENTERCRITICAL();
+  poolPt->next = Pools;
+  Pools = poolPt;
+  OS_EXITCRITICAL();
+  return SUCCESS;
+}
+
+//***********************************************************************
+//
+// OS_Pool_Alloc takes a block out of a pool.  Does not block, so it may
+// be called from an ISR.
+//
+// \param poolPt is the pool.
+//
+// \return the block, or NULL if the pool is empty.
+//
+//***********************************************************************
+void *
+OS_Pool_Alloc(PoolType *poolPt)
+{
+  void * block;
+  long sr;
+  unsigned long timeIoff;
+
+  OS_ENTERCRITICAL();
+  block = poolPt->freeList;
+  if(block == NULL)
+  {
+    poolPt->fails++;
+  }
+  else
+  {
+    poolPt->freeList = *(void **)block;
+    poolPt->used++;
+    poolPt->allocs++;
+    if(poolPt->used > poolPt->maxUsed)
+    {
+      poolPt->maxUsed = poolPt->used;
+    }
+  }
+  OS_EXITCRITICAL();
+  return block;
+}
+
+//***********************************************************************
+//
+// OS_Pool_Free gives a block back to the pool it came from.  Does not
+// block, so it may be called from an ISR.
+//
+// \param poolPt is the pool the block was allocated from.
+// \param blockPt is the block, NULL is ignored.
+//
+// \return none.
+//
+//***********************************************************************
+void
+OS_Pool_Free(PoolType *poolPt, void *blockPt)
+{
+  long sr;
+  unsigned long timeIoff;
+
+  if(blockPt == NULL)
+  {
+    return;
+  }
+  OS_ENTERCRITICAL();
+  *(void **)blockPt = poolPt->freeList;
+  poolPt->freeList = blockPt;
+  poolPt->used--;
+  OS_EXITCRITICAL();
+}
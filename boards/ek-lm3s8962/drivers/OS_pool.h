@@ -0,0 +1,29 @@
+//*****************************************************************************
+//
+// OS_pool.h contains the fixed-block memory pools.  drivers/OS.h must be
+// included first.
+//
+//*****************************************************************************
+
+// unsigned longs of storage for a pool of numBlocks blocks of blockSize bytes
+#define POOL_WORDS(blockSize, numBlocks) \
+  ((((blockSize) + sizeof(unsigned long) - 1)/sizeof(unsigned long))*(numBlocks))
+
+typedef struct PoolType{
+  void * freeList;              // first free block, each holds the next
+  unsigned long blockSize;      // bytes in a block, a multiple of 4
+  unsigned long numBlocks;
+  unsigned long used;           // blocks handed out now
+  unsigned long maxUsed;        // most blocks ever handed out at once
+  unsigned long allocs;         // successful OS_Pool_Alloc calls
+  unsigned long fails;          // OS_Pool_Alloc calls that found it empty
+  const char * name;            // shown by the Pools command
+  struct PoolType * next;       // every pool created, newest first
+}PoolType;
+
+extern PoolType * Pools;
+
+extern int OS_Pool_Create(PoolType *poolPt, const char *name, void *storage,
+                          unsigned long blockSize, unsigned long numBlocks);
+extern void * OS_Pool_Alloc(PoolType *poolPt);
+extern void OS_Pool_Free(PoolType *poolPt, void *blockPt);
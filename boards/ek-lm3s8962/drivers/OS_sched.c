@@ -0,0 +1,489 @@
+//*****************************************************************************
+//
+// Filename: OS_sched.c
+// Description: Ready queues for the thread scheduler.  Each priority level
+// has its own circular, doubly linked list of ready threads and a bit in
+// ReadyBitmap that is set while the list is not empty.  Picking the next
+// thread is a count-leading-zeros of the bitmap, so the cost of a thread
+// switch does not depend on the number of threads in the system.
+//
+// Bit (31 - priority) of ReadyBitmap corresponds to priority level
+// 'priority', so the leading zero count is the highest ready priority
+// (0 is the highest priority).
+//
+// Sleeping threads are kept in SleepList, a delta queue sorted by wake up
+// time.  The sleepCount of each sleeping thread is the number of
+// milliseconds after the thread ahead of it in the list, so the OS tick
+// only has to decrement the head of the list.  The delta queue has its
+// own links, so a thread with a wait timeout can be on a wait queue and
+// in the delta queue at the same time, and is taken out of either one in
+// O(1) when the other wakes it.
+//
+// A blocked thread is kept on the wait queue of whatever it is blocked on
+// (a semaphore for example).  A wait queue is a circular, doubly linked
+// list sorted by priority, so the highest priority waiter is always at
+// the front.  Threads of equal priority are served first come, first
+// served.
+//
+// These functions do not disable interrupts, the caller must already be
+// in a critical section.
+//
+//*****************************************************************************
+
+#include "drivers/OS.h"
+#include "drivers/OS_sched.h"
+#include "string.h"
+
+//***********************************************************************
+//
+// MACROS
+//
+//***********************************************************************
+#ifdef __CC_ARM
+#define OS_CLZ(x) __clz(x)
+#else
+#define OS_CLZ(x) __builtin_clz((unsigned int)(x))
+#endif
+#define PRIO_BIT(p) (0x80000000UL >> (p))
+
+//***********************************************************************
+//
+// Global Variables
+//
+//***********************************************************************
+TCB * ReadyList[NUM_PRIORITIES];  // head of the ready list for each priority
+unsigned long ReadyBitmap;        // bit (31-p) set when ReadyList[p] != NULL
+TCB * SleepList;                  // delta queue of sleeping threads
+
+//***********************************************************************
+//
+// Sched_Init empties all of the ready lists.
+//
+// \param none.
+// \return none.
+//
+//***********************************************************************
+void
+Sched_Init(void)
+{
+  int priority;
+
+  for(priority = 0; priority < NUM_PRIORITIES; priority++)
+  {
+    ReadyList[priority] = NULL;
+  }
+  ReadyBitmap = 0;
+  SleepList = NULL;
+}
+
+//***********************************************************************
+//
+// Sched_ReadyInsert adds a thread to the end of the ready list for its
+// priority level.
+//
+// \param thread is the TCB to make ready, it must not already be on a
+// ready list.
+// \return none.
+//
+//***********************************************************************
+void
+Sched_ReadyInsert(TCB * thread)
+{
+  TCB * head = ReadyList[thread->priority];
+
+  thread->state = THREAD_READY;
+  if(head == NULL)
+  {
+    // First thread at this level points to itself
+    thread->next = thread;
+    thread->prev = thread;
+    ReadyList[thread->priority] = thread;
+    ReadyBitmap |= PRIO_BIT(thread->priority);
+  }
+  else
+  {
+    // The tail of a circular list is just before the head
+    thread->next = head;
+    thread->prev = head->prev;
+    head->prev->next = thread;
+    head->prev = thread;
+  }
+}
+
+//***********************************************************************
+//
+// Sched_ReadyRemove takes a thread off the ready list for its priority
+// level.
+//
+// \param thread is the TCB to remove, it must be on a ready list.
+// \return none.
+//
+//***********************************************************************
+void
+Sched_ReadyRemove(TCB * thread)
+{
+  if(thread->next == thread)
+  {
+    // Last thread at this level
+    ReadyList[thread->priority] = NULL;
+    ReadyBitmap &= ~PRIO_BIT(thread->priority);
+  }
+  else
+  {
+    thread->prev->next = thread->next;
+    thread->next->prev = thread->prev;
+    if(ReadyList[thread->priority] == thread)
+    {
+      ReadyList[thread->priority] = thread->next;
+    }
+  }
+  thread->next = NULL;
+  thread->prev = NULL;
+}
+
+//***********************************************************************
+//
+// Sched_PickNext returns the thread at the front of the highest priority
+// non-empty ready list and rotates that list so that threads of equal
+// priority take turns.
+//
+// \param idle is the idle thread, returned if no thread is ready.
+// \return the thread to run next.
+//
+//***********************************************************************
+TCB *
+Sched_PickNext(TCB * idle)
+{
+  TCB * next;
+  unsigned long priority;
+
+  if(ReadyBitmap == 0)
+  {
+    return idle;
+  }
+  priority = OS_CLZ(ReadyBitmap);
+  next = ReadyList[priority];
+  ReadyList[priority] = next->next;
+
+  return next;
+}
+
+//***********************************************************************
+//
+// Sched_ReadyPriority returns the highest priority level that has a
+// ready thread.
+//
+// \param none.
+// \return the priority, NUM_PRIORITIES if no thread is ready.
+//
+//***********************************************************************
+unsigned long
+Sched_ReadyPriority(void)
+{
+  if(ReadyBitmap == 0)
+  {
+    return NUM_PRIORITIES;
+  }
+  return OS_CLZ(ReadyBitmap);
+}
+
+//***********************************************************************
+//
+// DeltaInsert puts a thread in the sleep delta queue.  Threads that wake
+// up at the same time wake up in the order they were inserted.
+//
+//***********************************************************************
+static void
+DeltaInsert(TCB * thread, unsigned long sleepTime)
+{
+  TCB * prev = NULL;
+  TCB * searchPt = SleepList;
+
+  // Skip the threads that wake up first, making the time relative
+  // to the thread ahead of the new one
+  while((searchPt != NULL) && (searchPt->sleepCount <= sleepTime))
+  {
+    sleepTime -= searchPt->sleepCount;
+    prev = searchPt;
+    searchPt = searchPt->sleepNext;
+  }
+
+  // The thread behind the new one is now relative to the new one
+  if(searchPt != NULL)
+  {
+    searchPt->sleepCount -= sleepTime;
+    searchPt->sleepPrev = thread;
+  }
+  thread->sleepCount = sleepTime;
+  thread->sleepNext = searchPt;
+  thread->sleepPrev = prev;
+  if(prev != NULL)
+  {
+    prev->sleepNext = thread;
+  }
+  else
+  {
+    SleepList = thread;
+  }
+}
+
+//***********************************************************************
+//
+// Sched_SleepInsert puts a thread to sleep.  The thread must already be
+// off the ready lists.
+//
+// \param thread is the TCB to put to sleep.
+// \param sleepTime is the number of OS ticks (ms) to sleep, at least 1.
+// \return none.
+//
+//***********************************************************************
+void
+Sched_SleepInsert(TCB * thread, unsigned long sleepTime)
+{
+  thread->state = THREAD_SLEEPING;
+  DeltaInsert(thread, sleepTime);
+}
+
+//***********************************************************************
+//
+// Sched_TimeoutInsert starts the timeout of a thread that is blocked on
+// a wait queue.  If the timeout runs out first, Sched_SleepTick takes
+// the thread off the wait queue and sets its timedOut flag.
+//
+// \param thread is the TCB, already on a wait queue.
+// \param timeout is the number of OS ticks (ms) to wait, at least 1.
+// \return none.
+//
+//***********************************************************************
+void
+Sched_TimeoutInsert(TCB * thread, unsigned long timeout)
+{
+  thread->timedWait = 1;
+  thread->timedOut = 0;
+  DeltaInsert(thread, timeout);
+}
+
+//***********************************************************************
+//
+// Sched_SleepRemove takes a thread out of the sleep delta queue before
+// its time is up, for a thread woken before its wait timeout.  The time
+// it had left is given to the thread behind it.
+//
+// \param thread is the TCB to remove, it must be in the delta queue.
+// \return none.
+//
+//***********************************************************************
+void
+Sched_SleepRemove(TCB * thread)
+{
+  if(thread->sleepNext != NULL)
+  {
+    thread->sleepNext->sleepCount += thread->sleepCount;
+    thread->sleepNext->sleepPrev = thread->sleepPrev;
+  }
+  if(thread->sleepPrev != NULL)
+  {
+    thread->sleepPrev->sleepNext = thread->sleepNext;
+  }
+  else
+  {
+    SleepList = thread->sleepNext;
+  }
+  thread->sleepNext = NULL;
+  thread->sleepPrev = NULL;
+  thread->timedWait = 0;
+}
+
+//***********************************************************************
+//
+// Sched_SleepTick advances the sleep delta queue by one OS tick and
+// moves the threads that are done sleeping to the ready lists.  A
+// thread whose wait timed out leaves its wait queue, and gives back the
+// count it took from the semaphore it was waiting on.  A mutex it was
+// waiting for no longer passes priority on through it.
+//
+// \param none.
+// \return the number of threads that woke up.
+//
+//***********************************************************************
+int
+Sched_SleepTick(void)
+{
+  TCB * thread;
+  int woken = 0;
+
+  if(SleepList == NULL)
+  {
+    return 0;
+  }
+  if(SleepList->sleepCount > 0)
+  {
+    (SleepList->sleepCount)--;
+  }
+  while((SleepList != NULL) && (SleepList->sleepCount == 0))
+  {
+    thread = SleepList;
+    SleepList = thread->sleepNext;
+    if(SleepList != NULL)
+    {
+      SleepList->sleepPrev = NULL;
+    }
+    thread->sleepNext = NULL;
+    if(thread->state == THREAD_BLOCKED)
+    {
+      Sched_WaitRemove(thread);
+      if(thread->BlockPt != NULL)
+      {
+        (thread->BlockPt->value)++;
+        thread->BlockPt = NULL;
+      }
+      thread->MutexBlockPt = NULL;
+      thread->timedWait = 0;
+      thread->timedOut = 1;
+    }
+    Sched_ReadyInsert(thread);
+    woken++;
+  }
+
+  return woken;
+}
+
+//***********************************************************************
+//
+// Sched_WaitInsert adds a thread to a priority ordered wait queue.  The
+// thread must already be off the ready lists.  The search starts from
+// the back of the queue, so adding a thread that is not higher priority
+// than the last waiter does not search at all.
+//
+// \param waitList is the wait queue.
+// \param thread is the TCB to add.
+// \return none.
+//
+//***********************************************************************
+void
+Sched_WaitInsert(TCB ** waitList, TCB * thread)
+{
+  TCB * head = *waitList;
+  TCB * searchPt;
+
+  thread->state = THREAD_BLOCKED;
+  thread->waitList = waitList;
+  if(head == NULL)
+  {
+    thread->next = thread;
+    thread->prev = thread;
+    *waitList = thread;
+    return;
+  }
+
+  // Find the last waiter with the same or higher priority
+  searchPt = head->prev;
+  while((searchPt->priority > thread->priority) && (searchPt != head))
+  {
+    searchPt = searchPt->prev;
+  }
+
+  if(searchPt->priority > thread->priority)
+  {
+    // Higher priority than every waiter, the thread is the new head
+    searchPt = head->prev;
+    *waitList = thread;
+  }
+  thread->next = searchPt->next;
+  thread->prev = searchPt;
+  searchPt->next->prev = thread;
+  searchPt->next = thread;
+}
+
+//***********************************************************************
+//
+// Sched_WaitRemove takes a thread off the wait queue it is blocked on.
+// The caller decides where the thread goes next.
+//
+// \param thread is the TCB to remove, it must be on a wait queue.
+// \return none.
+//
+//***********************************************************************
+void
+Sched_WaitRemove(TCB * thread)
+{
+  TCB ** waitList = thread->waitList;
+
+  if(thread->next == thread)
+  {
+    *waitList = NULL;
+  }
+  else
+  {
+    thread->prev->next = thread->next;
+    thread->next->prev = thread->prev;
+    if(*waitList == thread)
+    {
+      *waitList = thread->next;
+    }
+  }
+  thread->next = NULL;
+  thread->prev = NULL;
+  thread->waitList = NULL;
+}
+
+//***********************************************************************
+//
+// Sched_WaitPop removes the highest priority thread from a wait queue.
+//
+// \param waitList is the wait queue.
+// \return the thread, NULL if the queue is empty.
+//
+//***********************************************************************
+TCB *
+Sched_WaitPop(TCB ** waitList)
+{
+  TCB * thread = *waitList;
+
+  if(thread != NULL)
+  {
+    Sched_WaitRemove(thread);
+  }
+  return thread;
+}
+
+//***********************************************************************
+//
+// Sched_SetPriority changes the priority of a thread and moves it to the
+// right place in the ready list or wait queue it is on.
+//
+// \param thread is the TCB to change.
+// \param priority is the new priority.
+// \return none.
+//
+//***********************************************************************
+void
+Sched_SetPriority(TCB * thread, unsigned long priority)
+{
+  TCB ** waitList;
+
+  if(thread->priority == priority)
+  {
+    return;
+  }
+  if(thread->state == THREAD_READY)
+  {
+    Sched_ReadyRemove(thread);
+    thread->priority = priority;
+    Sched_ReadyInsert(thread);
+  }
+  else if(thread->state == THREAD_BLOCKED)
+  {
+    waitList = thread->waitList;
+    Sched_WaitRemove(thread);
+    thread->priority = priority;
+    Sched_WaitInsert(waitList, thread);
+  }
+  else
+  {
+    // A sleeping thread uses the new priority when it wakes up
+    thread->priority = priority;
+  }
+}
+
+//******************************EOF**************************************
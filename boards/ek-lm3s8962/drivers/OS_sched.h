@@ -0,0 +1,25 @@
+//*****************************************************************************
+//
+// OS_sched.h contains the ready queues used by the OS to choose the next
+// thread to run, the delta queue of sleeping threads and the wait queues
+// of blocked threads.  drivers/OS.h must be included first.
+//
+//*****************************************************************************
+
+extern TCB * ReadyList[NUM_PRIORITIES];
+extern unsigned long ReadyBitmap;
+extern TCB * SleepList;
+
+extern void Sched_Init(void);
+extern void Sched_ReadyInsert(TCB * thread);
+extern void Sched_ReadyRemove(TCB * thread);
+extern TCB * Sched_PickNext(TCB * idle);
+extern unsigned long Sched_ReadyPriority(void);
+extern void Sched_SleepInsert(TCB * thread, unsigned long sleepTime);
+extern void Sched_TimeoutInsert(TCB * thread, unsigned long timeout);
+extern void Sched_SleepRemove(TCB * thread);
+extern int Sched_SleepTick(void);
+extern void Sched_WaitInsert(TCB ** waitList, TCB * thread);
+extern void Sched_WaitRemove(TCB * thread);
+extern TCB * Sched_WaitPop(TCB ** waitList);
+extern void Sched_SetPriority(TCB * thread, unsigned long priority);
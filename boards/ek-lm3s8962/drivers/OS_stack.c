@@ -0,0 +1,179 @@
+//*****************************************************************************
+//
+// Filename: OS_stack.c
+// Description: Thread stack allocator.  Stacks are carved out of one
+// static arena at the size asked for in OS_AddThread, rounded up to
+// 8 bytes.  Interrupts run on MSP, not on the thread stack.  A freed
+// stack is merged with free neighbors so the arena does not break up as
+// threads come and go.
+//
+// Every block starts with an 8 byte header holding the size of the block
+// (header included, bit 0 set while in use) and the size of the block
+// just before it, so both neighbors of a block are found without a
+// search.  Allocation is first fit.
+//
+// These functions do not disable interrupts, the caller must already be
+// in a critical section.
+//
+//*****************************************************************************
+
+#include "drivers/OS_stack.h"
+#include "string.h"
+
+//***********************************************************************
+//
+// MACROS
+//
+//***********************************************************************
+#define BLOCK_USED 1
+#define HEADER_SIZE 8
+#define BLOCK_SIZE(b) ((b)->size & ~BLOCK_USED)
+#define ARENA_START (&StackArena[0].block)
+#define ARENA_END ((Block *)(StackArena + STACK_ARENA_SIZE/sizeof(ArenaType)))
+
+typedef struct Block{
+  unsigned long size;       // bytes in this block, BLOCK_USED while allocated
+  unsigned long prevSize;   // bytes in the block before, 0 for the first
+}Block;
+
+typedef union ArenaType{
+  Block block;
+  unsigned long long align; // keeps every stack 8 byte aligned
+}ArenaType;
+
+//***********************************************************************
+//
+// Global Variables
+//
+//***********************************************************************
+static ArenaType StackArena[STACK_ARENA_SIZE/sizeof(ArenaType)];
+
+//***********************************************************************
+//
+// NextBlock returns the block just after blk, ARENA_END for the last.
+//
+//***********************************************************************
+static Block *
+NextBlock(Block * blk)
+{
+  return (Block *)((unsigned char *)blk + BLOCK_SIZE(blk));
+}
+
+//***********************************************************************
+//
+// Stack_Init makes the whole arena one free block.
+//
+// \param none.
+// \return none.
+//
+//***********************************************************************
+void
+Stack_Init(void)
+{
+  ARENA_START->size = STACK_ARENA_SIZE;
+  ARENA_START->prevSize = 0;
+}
+
+//***********************************************************************
+//
+// Stack_Alloc takes a stack from the arena.
+//
+// \param size is the stack size in bytes, at least STACK_MIN_SIZE.
+// \return the lowest address of the stack, NULL if there is no room or
+// size is too small.
+//
+//***********************************************************************
+unsigned char *
+Stack_Alloc(unsigned long size)
+{
+  Block * blk;
+  Block * rest;
+  unsigned long need;
+
+  if((size < STACK_MIN_SIZE) || (size > STACK_ARENA_SIZE))
+  {
+    return NULL;
+  }
+  need = ((size + 7) & ~7UL) + HEADER_SIZE;
+
+  for(blk = ARENA_START; blk < ARENA_END; blk = NextBlock(blk))
+  {
+    if(!(blk->size & BLOCK_USED) && (blk->size >= need))
+    {
+      // Split off the end of the block if it is big enough to be a stack
+      if(blk->size - need >= HEADER_SIZE + STACK_MIN_SIZE)
+      {
+        rest = (Block *)((unsigned char *)blk + need);
+        rest->size = blk->size - need;
+        rest->prevSize = need;
+        if(NextBlock(rest) < ARENA_END)
+        {
+          NextBlock(rest)->prevSize = rest->size;
+        }
+        blk->size = need;
+      }
+      blk->size |= BLOCK_USED;
+      return (unsigned char *)blk + HEADER_SIZE;
+    }
+  }
+  return NULL;
+}
+
+//***********************************************************************
+//
+// Stack_Free returns a stack to the arena and merges it with the free
+// blocks on either side.
+//
+// \param stack is the value returned by Stack_Alloc.
+// \return none.
+//
+//***********************************************************************
+void
+Stack_Free(unsigned char * stack)
+{
+  Block * blk = (Block *)(stack - HEADER_SIZE);
+  Block * next;
+  Block * prev;
+
+  blk->size &= ~BLOCK_USED;
+
+  // Merge with the block after
+  next = NextBlock(blk);
+  if((next < ARENA_END) && !(next->size & BLOCK_USED))
+  {
+    blk->size += next->size;
+  }
+
+  // Merge with the block before
+  if(blk->prevSize != 0)
+  {
+    prev = (Block *)((unsigned char *)blk - blk->prevSize);
+    if(!(prev->size & BLOCK_USED))
+    {
+      prev->size += blk->size;
+      blk = prev;
+    }
+  }
+
+  next = NextBlock(blk);
+  if(next < ARENA_END)
+  {
+    next->prevSize = blk->size;
+  }
+}
+
+//***********************************************************************
+//
+// Stack_Size returns the number of bytes usable in a stack.
+//
+// \param stack is the value returned by Stack_Alloc.
+// \return the stack size in bytes.
+//
+//***********************************************************************
+unsigned long
+Stack_Size(unsigned char * stack)
+{
+  return BLOCK_SIZE((Block *)(stack - HEADER_SIZE)) - HEADER_SIZE;
+}
+
+//******************************EOF**************************************
@@ -0,0 +1,15 @@
+//*****************************************************************************
+//
+// OS_stack.h contains the allocator that carves thread stacks out of the
+// stack arena.
+//
+//*****************************************************************************
+
+#define STACK_ARENA_SIZE 8192 		// bytes shared by all thread stacks
+#define STACK_MIN_SIZE 64 			// smallest stack handed out, in bytes, the
+									// registers saved when a thread is switched out
+
+extern void Stack_Init(void);
+extern unsigned char * Stack_Alloc(unsigned long size);
+extern void Stack_Free(unsigned char * stack);
+extern unsigned long Stack_Size(unsigned char * stack);
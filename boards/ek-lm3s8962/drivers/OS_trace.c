@@ -0,0 +1,250 @@
+//*****************************************************************************
+//
+// Filename: OS_trace.c
+// Description: Kernel trace ring.  Thread switches, periodic threads,
+// semaphore blocks and wakes, and interrupt handlers each write an 8 byte
+// record stamped with the raw OS_Time count.  Writers never wait: a slot is
+// claimed with LDREX/STREX, so any interrupt may write a record.  Each
+// slot also holds a sequence number, the claimed index while the record
+// is being written and one past it once it is complete.  The drain checks
+// it before and after copying a record, so a writer that laps the drain
+// mid-copy is counted as lost instead of sending a torn record.
+//
+// Trace_Thread drains the ring to the UART or to TRACE_FILE.  Every record
+// goes out as TRACE_SYNC followed by the 8 record bytes, little endian.  If
+// the writers lap the drain, the records that were lost are reported with
+// a TRACE_LOST record.  tools/trace2json.c turns the output into a Chrome
+// trace.
+//
+//*****************************************************************************
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "drivers/OS.h"
+#include "drivers/OS_trace.h"
+#include "drivers/OSuart.h"
+#include "drivers/efile.h"
+
+//***********************************************************************
+//
+// Structures
+//
+//***********************************************************************
+typedef struct TraceSlot{
+  TraceRecord rec;
+  unsigned long seq;      // index while written, index+1 once complete
+}TraceSlot;
+
+//***********************************************************************
+//
+// Global Variables
+//
+//***********************************************************************
+volatile TraceSlot TraceRing[TRACE_SIZE];
+volatile unsigned long TraceHead;   // records claimed by writers, wraps
+unsigned long TraceTail;            // records taken by Trace_Thread
+unsigned long TraceLost;            // records lapped since the last TRACE_LOST
+unsigned char TraceSink;            // where the trace is going now
+volatile unsigned char TraceRequest;   // where Trace_Start asked it to go
+unsigned char TraceThreadAdded;
+
+//***********************************************************************
+//
+// TraceClaim returns the index of the next free record.
+//
+//***********************************************************************
+static unsigned long
+TraceClaim(void)
+{
+#if defined(__ARMCC_VERSION)
+  unsigned long index;
+  do
+  {
+    index = __ldrex(&TraceHead);
+  }
+  while(__strex(index+1, &TraceHead));
+  return index;
+#else
+  return __sync_fetch_and_add(&TraceHead, 1);
+#endif
+}
+
+//***********************************************************************
+//
+// Trace_Event adds a record to the trace ring.  It may be called from
+// any thread or interrupt handler.
+//
+// \param event is the kind of record, TRACE_SWITCH through TRACE_LOST.
+// \param id is the thread, periodic thread or ISR class.
+// \param arg is extra data for the event.
+// \return none.
+//
+//***********************************************************************
+void
+Trace_Event(unsigned char event, unsigned char id, unsigned short arg)
+{
+  unsigned long index = TraceClaim();
+  volatile TraceSlot * slot = &TraceRing[index & (TRACE_SIZE-1)];
+
+  slot->seq = index;
+  slot->rec.time = OS_Time();
+  slot->rec.event = event;
+  slot->rec.id = id;
+  slot->rec.arg = arg;
+  slot->seq = index+1;
+}
+
+//***********************************************************************
+//
+// TraceGet takes the oldest complete record from the ring.
+//
+// \return 1 if \param rec was filled in, 0 if there is nothing to take.
+//
+//***********************************************************************
+static int
+TraceGet(TraceRecord * rec)
+{
+  unsigned long head;
+  unsigned long seq;
+  volatile TraceSlot * slot;
+
+  for(;;)
+  {
+    // Skip the records that the writers have written over
+    head = TraceHead;
+    if(head - TraceTail > TRACE_SIZE)
+    {
+      TraceLost += head - TraceTail - TRACE_SIZE;
+      TraceTail = head - TRACE_SIZE;
+    }
+    if(TraceTail == head)
+    {
+      return 0;
+    }
+    slot = &TraceRing[TraceTail & (TRACE_SIZE-1)];
+    seq = slot->seq;
+    if(seq != TraceTail+1)
+    {
+      if(TraceHead - TraceTail > TRACE_SIZE)
+      {
+        continue;   // a writer has claimed the slot again
+      }
+      return 0;     // still being written
+    }
+    *rec = slot->rec;
+    if(slot->seq == seq)
+    {
+      TraceTail++;
+      return 1;
+    }
+    // A writer lapped the drain during the copy, the record is lost
+  }
+}
+
+//***********************************************************************
+//
+// TraceOut sends one record to the sink.
+//
+//***********************************************************************
+static void
+TraceOut(TraceRecord * rec)
+{
+  unsigned char * data = (unsigned char *)rec;
+  int i;
+
+  for(i = -1; i < (int)sizeof(TraceRecord); i++)
+  {
+    if(TraceSink == TRACE_TO_UART)
+    {
+      OSuart_OutChar(UART0_BASE, (i < 0) ? TRACE_SYNC : data[i]);
+    }
+    else
+    {
+      eFile_Write((i < 0) ? TRACE_SYNC : data[i]);
+    }
+  }
+}
+
+//***********************************************************************
+//
+// Trace_Start chooses where the trace is drained to.  The first call
+// adds Trace_Thread.  The switch happens at the next drain.
+//
+// \param sink is TRACE_OFF, TRACE_TO_UART or TRACE_TO_FILE.
+// \return SUCCESS, or FAIL if Trace_Thread could not be added.
+//
+//***********************************************************************
+int
+Trace_Start(unsigned char sink)
+{
+  if(!TraceThreadAdded)
+  {
+    if(OS_AddThread(&Trace_Thread, 256, TRACE_PRIORITY) == FAIL)
+    {
+      return FAIL;
+    }
+    TraceThreadAdded = 1;
+  }
+  TraceRequest = sink;
+  return SUCCESS;
+}
+
+//***********************************************************************
+//
+// Trace_Thread drains the trace ring every TRACE_DRAIN_MS.  Only as many
+// records as the UART can send in that time are taken at once, the rest
+// wait in the ring.
+//
+//***********************************************************************
+void
+Trace_Thread(void)
+{
+  TraceRecord rec;
+  TraceRecord lost;
+  int count;
+
+  for(;;)
+  {
+    // Change sinks between drains so a file is never closed mid-record
+    if(TraceRequest != TraceSink)
+    {
+      if(TraceSink == TRACE_TO_FILE)
+      {
+        eFile_WClose();
+      }
+      TraceSink = TraceRequest;
+      if((TraceSink == TRACE_TO_FILE) && eFile_WOpen(TRACE_FILE))
+      {
+        TraceSink = TRACE_OFF;
+        TraceRequest = TRACE_OFF;
+      }
+      // Start from the oldest records still in the ring
+      if(TraceHead - TraceTail > TRACE_SIZE)
+      {
+        TraceTail = TraceHead - TRACE_SIZE;
+      }
+      TraceLost = 0;
+    }
+
+    count = 0;
+    while((TraceSink != TRACE_OFF) &&
+          ((TraceSink == TRACE_TO_FILE) || (count < TRACE_UART_RECORDS)) &&
+          TraceGet(&rec))
+    {
+      if(TraceLost)
+      {
+        lost.time = rec.time;
+        lost.event = TRACE_LOST;
+        lost.id = 0;
+        lost.arg = (TraceLost > 0xFFFF) ? 0xFFFF : (unsigned short)TraceLost;
+        TraceLost = 0;
+        TraceOut(&lost);
+      }
+      TraceOut(&rec);
+      count++;
+    }
+    OS_Sleep(TRACE_DRAIN_MS);
+  }
+}
+
+//******************************EOF**************************************
@@ -0,0 +1,41 @@
+//*****************************************************************************
+//
+// OS_trace.h contains the kernel trace ring.  Records are written by the
+// kernel and interrupt handlers and drained by Trace_Thread to the UART or
+// to a file.  drivers/OS.h must be included first.
+//
+//*****************************************************************************
+
+#define TRACE_SIZE 256				// records in the ring, must be a power of 2
+#define TRACE_SYNC 0xA5				// byte sent ahead of every record
+#define TRACE_DRAIN_MS 10			// time between drains
+#define TRACE_UART_RECORDS 12 		// records per drain that fit 115200 baud
+#define TRACE_PRIORITY 1			// priority of Trace_Thread
+#define TRACE_FILE "trace.bin"		// file used by TRACE_TO_FILE
+
+// Trace events
+#define TRACE_NONE 0
+#define TRACE_SWITCH 1				// id = thread switched out, arg = thread switched in
+#define TRACE_PERIODIC_START 2		// id = periodic thread
+#define TRACE_PERIODIC_END 3		// id = periodic thread
+#define TRACE_SEM_BLOCK 4			// id = thread, arg = semaphore address
+#define TRACE_SEM_WAKE 5			// id = thread, arg = semaphore address
+#define TRACE_ISR_ENTER 6			// id = ISR class
+#define TRACE_ISR_EXIT 7			// id = ISR class
+#define TRACE_LOST 8				// arg = records dropped before this one
+
+// Where the trace is drained to
+#define TRACE_OFF 0
+#define TRACE_TO_UART 1
+#define TRACE_TO_FILE 2
+
+typedef struct TraceRecord{
+  unsigned long time;     // OS_Time, counts up in 20 ns cycles
+  unsigned char event;
+  unsigned char id;
+  unsigned short arg;
+}TraceRecord;
+
+extern void Trace_Event(unsigned char event, unsigned char id, unsigned short arg);
+extern int Trace_Start(unsigned char sink);
+extern void Trace_Thread(void);
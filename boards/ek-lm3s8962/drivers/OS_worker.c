@@ -0,0 +1,94 @@
+//*****************************************************************************
+//
+// Filename: OS_worker.c
+// Description: Worker thread pool.  OS_InitWorkers creates a fixed number
+// of threads once, and each one loops taking jobs off a queue and running
+// them.  Handing a job to the pool with OS_Submit is a queue put and a
+// signal, where OS_AddThread would find a TCB, build a stack and walk the
+// thread lists for every job.  A worker that finishes a job goes back to
+// waiting for the next one instead of being killed.
+//
+// The queue is a job queue from OS_defer.c, like the deferred work
+// thread's.  Unlike that thread, the workers run at a priority the
+// application picks and a job may block or sleep, since the other workers
+// keep taking jobs meanwhile.
+//
+//*****************************************************************************
+
+#include "drivers/OS.h"
+#include "drivers/OS_defer.h"
+#include "drivers/OS_worker.h"
+
+//***********************************************************************
+//
+// Global Variables
+//
+//***********************************************************************
+JobType WorkJobs[JOB_QUEUE_SIZE];
+JobQueueType WorkQueue;
+unsigned long NumWorkers;
+
+//***********************************************************************
+//
+// WorkerThread is the body of every worker, it runs the jobs oldest
+// first.
+//
+//***********************************************************************
+static void
+WorkerThread(void)
+{
+  for(;;)
+  {
+    JobQueue_Run(&WorkQueue);
+  }
+}
+
+//***********************************************************************
+//
+// OS_InitWorkers empties the job queue and starts the worker threads.
+// Call it once, after OS_Init.
+//
+// \param numWorkers is the number of threads in the pool, at most
+// MAX_WORKERS.
+// \param priority is the priority the jobs run at.
+//
+// \return SUCCESS, or FAIL if the threads could not all be added.
+//
+//***********************************************************************
+int
+OS_InitWorkers(unsigned long numWorkers, unsigned long priority)
+{
+  JobQueue_Init(&WorkQueue, WorkJobs, JOB_QUEUE_SIZE);
+  NumWorkers = 0;
+
+  if(numWorkers > MAX_WORKERS)
+  {
+    return FAIL;
+  }
+  while(NumWorkers < numWorkers)
+  {
+    if(OS_AddThread(&WorkerThread, WORKER_STACK_SIZE, priority) == FAIL)
+    {
+      return FAIL;
+    }
+    NumWorkers++;
+  }
+  return SUCCESS;
+}
+
+//***********************************************************************
+//
+// OS_Submit queues a job for the next free worker.  Does not block, so
+// it may be called from an ISR.
+//
+// \param job is the function to run.
+// \param arg is passed to \param job.
+//
+// \return SUCCESS, or FAIL if the queue is full and the job was dropped.
+//
+//***********************************************************************
+int
+OS_Submit(void(*job)(unsigned long), unsigned long arg)
+{
+  return JobQueue_Put(&WorkQueue, job, arg);
+}
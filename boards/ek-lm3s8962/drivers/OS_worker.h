@@ -0,0 +1,17 @@
+//*****************************************************************************
+//
+// OS_worker.h contains the pool of worker threads that run jobs handed to
+// them by ISRs and threads.  drivers/OS.h and drivers/OS_defer.h must be
+// included first.
+//
+//*****************************************************************************
+
+#define MAX_WORKERS 4				// most threads in the pool
+#define JOB_QUEUE_SIZE 16			// jobs waiting for a worker
+#define WORKER_STACK_SIZE 512		// bytes, the jobs run on this stack
+
+extern JobQueueType WorkQueue;      // jobs for the workers, busy is the workers running one
+extern unsigned long NumWorkers;    // threads in the pool
+
+extern int OS_InitWorkers(unsigned long numWorkers, unsigned long priority);
+extern int OS_Submit(void(*job)(unsigned long), unsigned long arg);
@@ -37,17 +37,21 @@
 #include "string.h"
 #include "drivers/OS.h"
 #include "drivers/OSuart.h"
+#include "drivers/OS_trace.h"
+#include "drivers/OS_pool.h"
+#include "drivers/OS_defer.h"
+#include "drivers/OS_worker.h"
+#include "drivers/OS_periodic.h"
 
 // Global Variables
   AddFifo(UARTRx, 256, unsigned char, 1, 0);   // UARTRx Buffer
   AddFifo(UARTTx, 256, unsigned char, 1, 0);   // UARTTx Buffer
 
-#define NUM_EVENTS 100
-#define PER_THREAD_START 0x04
-#define PER_THREAD_END   0x08
-#define FOREGROUND_THREAD_START 0x03
 #define GPIO_B3 (*((volatile unsigned long *)(0x40005020)))
 
+#define UART_FLAG_RX 0x01     // UARTFlags: UARTRx has data
+FlagsType UARTFlags;
+
 // Private Functions
 void UARTSend(const unsigned char *pucBuffer, unsigned long ulCount);
 unsigned char Buffer[100];  // Buffer size for interpreter input
@@ -57,9 +61,24 @@ unsigned short FirstSpace = 1; // Boolean to determine if first space has occure
 extern unsigned long NumCreated;   // number of foreground threads created
 extern unsigned long NumSamples;   // incremented every sample
 extern unsigned long DataLost;     // data sent by Producer, but not received by Consumer
-extern unsigned long RunTimeProfile[NUM_EVENTS][2];
-extern int EventIndex;
+extern unsigned long MutexInversions;     // inversions bounded by OS_MutexLock
+extern unsigned long MutexInversionMax;   // longest inversion in usec
+extern unsigned long MutexInversionTotal; // total inversion time in usec
+extern unsigned long WakeLatencyCount;    // woken threads that have run
+extern unsigned long WakeLatencyMax;      // longest wake-to-run latency in 0.1 usec
+extern unsigned long WakeLatencyTotal;    // total wake-to-run latency in 0.1 usec
+extern unsigned long CpuLoad1s;           // CPU load over the last second, in 0.1%
+extern unsigned long CpuLoad10s;          // over the last LOAD_WINDOW seconds, in 0.1%
 extern int WriteToFile;
+extern TCB OSThreads[MAX_NUM_OS_THREADS];
+extern unsigned long long IsrRunTime[NUM_ISR_CLASSES];   // clock cycles in each ISR class
+extern unsigned long TimeIbitDisabled;       // longest critical section in clock cycles
+extern CritSiteType * CritMaxSite;
+extern CritSiteType CritSites[CRIT_SITES];
+extern unsigned char CritNumSites;
+extern unsigned long CritHistogram[CRIT_BUCKETS];
+long SRSave (void);
+void SRRestore(long sr);
 
 //*****************************************************************************
 //
@@ -95,6 +114,9 @@ UARTIntHandler(void)
 {
   unsigned long ulStatus;
   unsigned char uartData;
+  unsigned long startTime = OS_Time();
+
+  Trace_Event(TRACE_ISR_ENTER, ISR_UART, 0);
     //
     // Get the interrrupt status.
     //
@@ -126,6 +148,7 @@ UARTIntHandler(void)
 		    //error 
       }
     }
+    OS_SetFlags(&UARTFlags, UART_FLAG_RX);
   }
 
   if(ulStatus == UART_INT_TX)
@@ -139,6 +162,7 @@ UARTIntHandler(void)
       UARTCharPut(UART0_BASE,uartData);
     }
   }        
+  OS_ChargeIsr(ISR_UART, startTime);
 }    
 
 
@@ -162,6 +186,213 @@ UARTSend(const unsigned char *pucBuffer, unsigned long ulCount)
     }
 }
 extern void Jitter(void);
+
+//*****************************************************************************
+//
+// Print the share of the CPU each thread and ISR class has used since
+// launch, with the state, priority and switch count of each thread.
+//
+//*****************************************************************************
+typedef struct TopThreadType{
+  unsigned long long runTime;
+  unsigned long priority;
+  unsigned long switches;
+  unsigned long overruns;
+  unsigned char id;
+  unsigned char state;
+}TopThreadType;
+TopThreadType TopThreads[MAX_NUM_OS_THREADS];   // the threads being printed
+unsigned long long TopIsrTime[NUM_ISR_CLASSES];
+void
+OSuart_Top(void)
+{
+  static char * const stateNames[3] = {"Ready", "Sleep", "Block"};
+  static char * const isrNames[NUM_ISR_CLASSES] = {"Periodic", "SysTick", "UART", "CAN"};
+  char report[60];
+  unsigned long long total = 0;
+  unsigned long percent;     // in 0.1%
+  long sr;
+  int i, n = 0;
+
+  // Copy the counters with interrupts off so they add up
+  sr = SRSave();
+  for(i = 0; i < MAX_NUM_OS_THREADS; i++)
+  {
+    if(OSThreads[i].id != DEAD)
+    {
+      TopThreads[n].runTime = OSThreads[i].runTime;
+      TopThreads[n].priority = OSThreads[i].priority;
+      TopThreads[n].switches = OSThreads[i].switches;
+      TopThreads[n].overruns = OSThreads[i].overruns;
+      TopThreads[n].id = OSThreads[i].id;
+      TopThreads[n].state = OSThreads[i].state;
+      n++;
+    }
+  }
+  memcpy(TopIsrTime, IsrRunTime, sizeof(TopIsrTime));
+  SRRestore(sr);
+
+  for(i = 0; i < n; i++)
+  {
+    total += TopThreads[i].runTime;
+  }
+  for(i = 0; i < NUM_ISR_CLASSES; i++)
+  {
+    total += TopIsrTime[i];
+  }
+  if(total == 0)
+  {
+    total = 1;
+  }
+
+  OSuart_OutString(UART0_BASE, "\r\nID  Pri State   CPU%  Switches Overruns");
+  for(i = 0; i < n; i++)
+  {
+    percent = (unsigned long)((TopThreads[i].runTime*1000)/total);
+    sprintf(report, "\r\n%2u %4lu %-5s %3lu.%lu %9lu %8lu", TopThreads[i].id, TopThreads[i].priority, 
+            stateNames[TopThreads[i].state], percent/10, percent%10, TopThreads[i].switches,
+            TopThreads[i].overruns);
+    OSuart_OutString(UART0_BASE, report);
+  }
+  for(i = 0; i < NUM_ISR_CLASSES; i++)
+  {
+    percent = (unsigned long)((TopIsrTime[i]*1000)/total);
+    sprintf(report, "\r\n%-14s %3lu.%lu", isrNames[i], percent/10, percent%10);
+    OSuart_OutString(UART0_BASE, report);
+  }
+}
+
+//*****************************************************************************
+//
+// Print how long critical sections kept interrupts disabled: the longest,
+// a histogram, and the longest and count for each call site.
+//
+//*****************************************************************************
+#if OS_PROFILE_CRITICAL
+static const char *
+BaseName(const char * file)
+{
+  const char * name = file;
+
+  while(*file)
+  {
+    if((*file == '\\') || (*file == '/'))
+    {
+      name = file + 1;
+    }
+    file++;
+  }
+  return name;
+}
+#endif
+
+void
+OSuart_Crit(void)
+{
+#if OS_PROFILE_CRITICAL
+  char report[60];
+  int i;
+
+  if(CritMaxSite != NULL)
+  {
+    sprintf(report, "\r\nLongest=%luus at %s:%u", TimeIbitDisabled/(1000/CLOCK_PERIOD), 
+            BaseName(CritMaxSite->file), CritMaxSite->line);
+    OSuart_OutString(UART0_BASE, report);
+  }
+  for(i = 0; i < CRIT_BUCKETS; i++)
+  {
+    sprintf(report, "\r\n%s%5luus %lu", (i == CRIT_BUCKETS-1) ? ">=" : " <", 
+            (i == CRIT_BUCKETS-1) ? (1UL << (i-1)) : (1UL << i), CritHistogram[i]);
+    OSuart_OutString(UART0_BASE, report);
+  }
+  for(i = 0; i < CritNumSites; i++)
+  {
+    sprintf(report, "\r\n%-14s %4u n=%-8lu max=%luus", BaseName(CritSites[i].file), 
+            CritSites[i].line, CritSites[i].count, CritSites[i].max/(1000/CLOCK_PERIOD));
+    OSuart_OutString(UART0_BASE, report);
+  }
+#else
+  OSuart_OutString(UART0_BASE, "\r\nBuild with OS_PROFILE_CRITICAL 1 in OS.h");
+#endif
+}
+
+void
+OSuart_Pools(void)
+{
+  char report[60];
+  PoolType * pool;
+
+  for(pool = Pools; pool != NULL; pool = pool->next)
+  {
+    sprintf(report, "\r\n%-10s %4luB used=%lu/%lu max=%lu fails=%lu", pool->name, 
+            pool->blockSize, pool->used, pool->numBlocks, pool->maxUsed, pool->fails);
+    OSuart_OutString(UART0_BASE, report);
+  }
+}
+
+void
+OSuart_Sched(void)
+{
+  char report[60];
+  unsigned long load, busy, unknown, minPeriod = 0;
+  int id, ok;
+
+  for(id = 0; id < NumPeriodic; id++)
+  {
+    sprintf(report, "\r\n%2d T=%luus C=%luus budget=%luus", id+1,
+            PeriodicTasks[id].period/(1000/CLOCK_PERIOD), PeriodicTasks[id].wcet/(1000/CLOCK_PERIOD),
+            PeriodicTasks[id].budget/(1000/CLOCK_PERIOD));
+    OSuart_OutString(UART0_BASE, report);
+    if((minPeriod == 0) || (PeriodicTasks[id].period < minPeriod))
+    {
+      minPeriod = PeriodicTasks[id].period;
+    }
+  }
+  ok = OS_PeriodicSchedulable(&load, &busy, &unknown);
+
+  // The kernel checks the sum of the costs against the shortest period
+  if(busy == 0xFFFFFFFF)
+  {
+    sprintf(report, "\r\nU=%lu.%lu%% busy=cost>=period %s", load/10, load%10,
+            ok ? "OK" : "LATE");
+  }
+  else
+  {
+    sprintf(report, "\r\nU=%lu.%lu%% busy=%luus Tmin=%luus %s", load/10, load%10,
+            busy/(1000/CLOCK_PERIOD), minPeriod/(1000/CLOCK_PERIOD), ok ? "OK" : "LATE");
+  }
+  OSuart_OutString(UART0_BASE, report);
+  sprintf(report, "\r\nAdds that failed the test=%lu", PeriodicUnschedulable);
+  OSuart_OutString(UART0_BASE, report);
+  sprintf(report, "\r\nTasks with no budget not run yet=%lu", unknown);
+  OSuart_OutString(UART0_BASE, report);
+}
+
+void
+OSuart_Jitter(void)
+{
+  char report[80];
+  JitterType * jitterPt;
+  int id;
+
+  for(id = 1; id <= NumPeriodic; id++)
+  {
+    jitterPt = &PeriodicTasks[id-1].jitter;
+    if(jitterPt->count == 0)
+    {
+      sprintf(report, "\r\n%2d n=0 miss=%lu", id, jitterPt->misses);
+      OSuart_OutString(UART0_BASE, report);
+      continue;
+    }
+    sprintf(report, "\r\n%2d n=%lu miss=%lu min=%ld max=%ld", id, jitterPt->count,
+            jitterPt->misses, jitterPt->min, jitterPt->max);
+    OSuart_OutString(UART0_BASE, report);
+    sprintf(report, "\r\n   p50=%ld p99=%ld p99.9=%ld", OS_JitterPercentile(id, 500),
+            OS_JitterPercentile(id, 990), OS_JitterPercentile(id, 999));
+    OSuart_OutString(UART0_BASE, report);
+  }
+}
+
 //*****************************************************************************
 //
 // Interpret input from the terminal. Supported functions include
@@ -183,10 +414,26 @@ OSuart_Interpret(unsigned char nextChar)
   short first = 1;
   short command, equation, cmdptr = 0; 
   short event = 0;
-  const short numcommands = 3;
   unsigned char data;
-  char * commands[numcommands] = {"NumSamples", "NumCreated", "DataLost"};
-  char * descriptions[numcommands] = {" - Display NumSamples\r\n", " - Display NumCreated\r\n", " - Display DataLost\r\n"};
+  static char * const commands[] = {"NumSamples", "NumCreated", "DataLost", "Mutex", "Latency", "Top", "Threads",
+                                         "TraceUart", "TraceFile", "TraceOff", "Crit", "Pools", "Load",
+                                         "Workers", "Sched", "Jitter"};
+  static char * const descriptions[] = {" - Display NumSamples\r\n", " - Display NumCreated\r\n", " - Display DataLost\r\n",
+                                             " - Display priority inversions bounded by OS_Mutex\r\n",
+                                             " - Display wake-to-run latency of signaled threads\r\n",
+                                             " - Display CPU use, state, priority, switches and overruns per thread\r\n",
+                                             " - Same as Top\r\n",
+                                             " - Stream the kernel trace out of this port\r\n",
+                                             " - Log the kernel trace to " TRACE_FILE "\r\n",
+                                             " - Stop the kernel trace\r\n",
+                                             " - Display how long critical sections disable interrupts\r\n",
+                                             " - Display blocks in use, most in use and failed allocs per pool\r\n",
+                                             " - Display CPU load over the last 1 s and 10 s\r\n",
+                                             " - Display busy workers, jobs run, queued and lost by the worker pool\r\n",
+                                             " - Display WCET and utilization of the periodic threads and whether they meet their deadlines\r\n",
+                                             " - Display jitter percentiles in cycles and missed releases per periodic thread\r\n"};
+  const short numcommands = sizeof(commands)/sizeof(commands[0]);
+  char report[60];
   switch(nextChar)
   {
     case '\x7F':
@@ -351,6 +598,77 @@ OSuart_Interpret(unsigned char nextChar)
 		  OSuart_OutString(UART0_BASE, " =");
 		  OSuart_OutString(UART0_BASE, string);	      //"format", "dir", "printfile", "deletefile"
 	   }
+     cmdptr++;                                                //mutex
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  sprintf(report, "\r\nInversions=%lu Max=%luus Total=%luus", MutexInversions, 
+		          MutexInversionMax, MutexInversionTotal);
+		  OSuart_OutString(UART0_BASE, report);
+	   }
+     cmdptr++;                                                //latency
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  total = WakeLatencyCount ? WakeLatencyTotal/WakeLatencyCount : 0;
+		  sprintf(report, "\r\nWakeups=%lu Avg=%lu.%luus Max=%lu.%luus", WakeLatencyCount, 
+		          total/10, total%10, WakeLatencyMax/10, WakeLatencyMax%10);
+		  OSuart_OutString(UART0_BASE, report);
+	   }
+     cmdptr++;                                                //top
+	   if((strcasecmp(token, commands[cmdptr]) == 0) || (strcasecmp(token, commands[cmdptr+1]) == 0))
+	   {	 
+		  OSuart_Top();
+	   }
+     cmdptr++;                                                //threads
+     cmdptr++;                                                //traceuart
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  Trace_Start(TRACE_TO_UART);
+	   }
+     cmdptr++;                                                //tracefile
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  Trace_Start(TRACE_TO_FILE);
+	   }
+     cmdptr++;                                                //traceoff
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  Trace_Start(TRACE_OFF);
+	   }
+     cmdptr++;                                                //crit
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  OSuart_Crit();
+	   }
+     cmdptr++;                                                //pools
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  OSuart_Pools();
+	   }
+     cmdptr++;                                                //load
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  sprintf(report, "\r\nLoad 1s=%lu.%lu%% 10s=%lu.%lu%%", CpuLoad1s/10, CpuLoad1s%10, 
+		          CpuLoad10s/10, CpuLoad10s%10);
+		  OSuart_OutString(UART0_BASE, report);
+	   }
+     cmdptr++;                                                //workers
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  sprintf(report, "\r\nbusy=%lu/%lu max=%lu run=%lu queue=%lu lost=%lu", 
+		          WorkQueue.busy, NumWorkers, WorkQueue.maxBusy, WorkQueue.run, WorkQueue.max,
+		          WorkQueue.lost);
+		  OSuart_OutString(UART0_BASE, report);
+	   }
+     cmdptr++;                                                //sched
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  OSuart_Sched();
+	   }
+     cmdptr++;                                                //jitter
+	   if(strcasecmp(token, commands[cmdptr]) == 0)
+	   {	 
+		  OSuart_Jitter();
+	   }
 
       
      token = strtok_r(NULL , " ", &last);  	
@@ -364,52 +682,22 @@ OSuart_Interpret(unsigned char nextChar)
    }
   }  
 
-OSuart_printTime(void)
-{
-  char string[50];
-  short event;
-  for(event = 0; event < NUM_EVENTS; event++) 
-  {
-     sprintf(string, "\r\n%i. ", event);
-	   OSuart_OutString(UART0_BASE, string);
-     if(RunTimeProfile[event][1] == PER_THREAD_START)
-     {
-       sprintf(string,"Periodic Thread Started at ");
-     }
-        if(RunTimeProfile[event][1] == PER_THREAD_END)
-        {
-           sprintf(string,"Periodic Thread Ended at ");
-        }        
-        if(RunTimeProfile[event][1] == FOREGROUND_THREAD_START)
-        {
-           sprintf(string,"Foreground Thread Started at ");
-        }
-        OSuart_OutString(UART0_BASE, string);
-        sprintf(string, "%i.", RunTimeProfile[event][0]);
-		    OSuart_OutString(UART0_BASE, string);
-        SysCtlDelay(SysCtlClockGet()/500);
-
-   }
-}
-
 void Interpreter(void)
 {
   unsigned char trigger;
   short fifo_status = 0;
   OSuart_Open();
-  while(NumSamples<RUNLENGTH)
+  for(;;)
   {  
     GPIO_B3 ^= 0x08;  
     fifo_status = UARTRxFifo_Get(&trigger);
-    if(fifo_status == 1)
-    OSuart_Interpret(trigger);
-	OS_Sleep(3);   //Give PID a chance to run
-  }
-  for(;;)
-  {
-    fifo_status = UARTRxFifo_Get(&trigger);
-    if(fifo_status == 1)
-    OSuart_Interpret(trigger);
+    while(fifo_status == 1)
+    {
+      OSuart_Interpret(trigger);
+      fifo_status = UARTRxFifo_Get(&trigger);
+    }
+    // Sleep until the UART ISR has more input, the PID threads run meanwhile
+    OS_WaitFlags(&UARTFlags, UART_FLAG_RX, FLAGS_ANY|FLAGS_CLEAR);
   }
 }      
 
@@ -525,6 +813,7 @@ void
 OSuart_Open(void)
 {
   UARTRxFifo_Init();
+  OS_InitFlags(&UARTFlags, 0);
  
   // Enable the peripherals used by this example.
   SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
@@ -6,9 +6,16 @@
 //*****************************************************************************
 
 
+#define INTERPRETER_STACK_SIZE 1024	// bytes, the interpreter formats its reports with sprintf
+
 void OSuart_Send(const unsigned char *pucBuffer, unsigned long ulCount);
 void OSuart_OutString(unsigned long ulBase, char *string);
 void OSuart_Open(void);
 void OSuart_Interpret(unsigned char nextChar);
+void OSuart_Top(void);
+void OSuart_Crit(void);
+void OSuart_Pools(void);
+void OSuart_Sched(void);
+void OSuart_Jitter(void);
 void Interpreter(void);
 void OSuart_OutChar(unsigned long ulBase, char string);
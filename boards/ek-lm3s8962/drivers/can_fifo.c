@@ -37,6 +37,7 @@
 #include "drivers/rit128x96x4.h"
 #include "drivers/can_fifo.h"
 #include "drivers/OS.h"
+#include "drivers/OS_trace.h"
 #include <string.h>
 
 extern struct sensors{
@@ -143,83 +144,110 @@ int iIdx;
 
 //*****************************************************************************
 //
-// The CAN controller interrupt handler.
+// Services the CAN controller, deferred from CANIntHandler.  Handles every
+// pending cause, then lets the controller interrupt again.
 //
 //*****************************************************************************
 unsigned long DebugPingCounter = 0;
 unsigned long DebugBytesRemaining = 0;
+unsigned long CANDeferLost = 0;     // times CANWork ran in the ISR
 
-void
-CANIntHandler(void)
+static void
+CANWork(unsigned long unused)
 {
-
     unsigned long ulStatus;
-	  IntMasterDisable();
 
     // Find the cause of the interrupt, if it is a status interrupt then just
     // acknowledge the interrupt by reading the status register.
-    ulStatus = CANIntStatus(CAN0_BASE, CAN_INT_STS_CAUSE);
-
-    // The first eight message objects make up the Transmit message FIFO.
-    if(ulStatus <= 8)
+    while((ulStatus = CANIntStatus(CAN0_BASE, CAN_INT_STS_CAUSE)) != 0)
     {
-        // Increment the number of bytes transmitted.
-        g_sCAN.ulBytesTransmitted += 8;
-    }
+        // The first eight message objects make up the Transmit message FIFO.
+        if(ulStatus <= 8)
+        {
+            // Increment the number of bytes transmitted.
+            g_sCAN.ulBytesTransmitted += 8;
+        }
 
-    // The second eight message objects make up the Receive message FIFO.
-    else if((ulStatus > 8) && (ulStatus <= 16))
-    {
+        // The second eight message objects make up the Receive message FIFO.
+        else if((ulStatus > 8) && (ulStatus <= 16))
+        {
 
-    	if(g_sCAN.MsgObjectRx.pucMsgData >= g_sCAN.pucBufferRx + CAN_FIFO_SIZE){
-		//
-    	// Reset the buffer pointer.
-    	//
-   		g_sCAN.MsgObjectRx.pucMsgData = g_sCAN.pucBufferRx;
-		}
-        //
-        // Read the data out and acknowledge that it was read.
-        //
-        CANMessageGet(CAN0_BASE, ulStatus, &g_sCAN.MsgObjectRx, 1);
+        	if(g_sCAN.MsgObjectRx.pucMsgData >= g_sCAN.pucBufferRx + CAN_FIFO_SIZE){
+    		//
+        	// Reset the buffer pointer.
+        	//
+       		g_sCAN.MsgObjectRx.pucMsgData = g_sCAN.pucBufferRx;
+    		}
+            //
+            // Read the data out and acknowledge that it was read.
+            //
+            CANMessageGet(CAN0_BASE, ulStatus, &g_sCAN.MsgObjectRx, 1);
 
 
 
-        //
-        // Advance the read pointer.
-        //
-        g_sCAN.MsgObjectRx.pucMsgData += 8;
+            //
+            // Advance the read pointer.
+            //
+            g_sCAN.MsgObjectRx.pucMsgData += 8;
 	
 
-        //
-        // Decrement the expected bytes remaining.
-        //
-        g_sCAN.ulBytesRemaining -= 8;
+            //
+            // Decrement the expected bytes remaining.
+            //
+            g_sCAN.ulBytesRemaining -= 8;
 
 		
 		
-		if (g_sCAN.pucBufferRx[0] == 'p')
-		{
-			DebugPingCounter++;
-		}
-    }
-    else
-    {
+    		if (g_sCAN.pucBufferRx[0] == 'p')
+    		{
+    			DebugPingCounter++;
+    		}
+        }
+        else
+        {
+            //
+            // This was a status interrupt so read the current status to
+            // clear the interrupt and return.
+            //
+            CANStatusGet(CAN0_BASE, CAN_STS_CONTROL);
+        }
+
         //
-        // This was a status interrupt so read the current status to
-        // clear the interrupt and return.
+        // Acknowledge the CAN controller interrupt has been handled.
         //
-        CANStatusGet(CAN0_BASE, CAN_STS_CONTROL);
+        CANIntClear(CAN0_BASE, ulStatus);
     }
 
-    //
-    // Acknowledge the CAN controller interrupt has been handled.
-    //
-    CANIntClear(CAN0_BASE, ulStatus);
+    CANIntEnable(CAN0_BASE, CAN_INT_MASTER | CAN_INT_ERROR);
+}
 
+//*****************************************************************************
+//
+// The CAN controller interrupt handler.  Leaves the message objects to
+// CANWork in the deferred work thread and masks the controller until it
+// has run.  If the deferred work queue is full the controller is
+// serviced here instead, and the miss is counted in CANDeferLost.
+//
+//*****************************************************************************
+void
+CANIntHandler(void)
+{
+    unsigned long startTime = OS_Time();
+    Trace_Event(TRACE_ISR_ENTER, ISR_CAN, 0);
 
-	IntMasterEnable();
-	
+    // CANWork cannot run before this ISR returns, so the controller is
+    // masked only once it is queued.  CANWork unmasks it when it is done.
+    if(OS_Defer(&CANWork, 0) == SUCCESS)
+    {
+        CANIntDisable(CAN0_BASE, CAN_INT_MASTER | CAN_INT_ERROR);
+    }
+    else
+    {
+        CANDeferLost++;
+        CANWork(0);
+    }
 
+	OS_ChargeIsr(ISR_CAN, startTime);
 }
 
 
@@ -512,8 +540,10 @@ void CAN_Init()
     CANIntEnable(CAN0_BASE, CAN_INT_MASTER | CAN_INT_ERROR);
 
     //
-    // Enable interrupts for the CAN in the NVIC.
+    // Enable interrupts for the CAN in the NVIC.  The handler calls the
+    // OS, so it must not be above OS_KERNEL_PRIORITY.
     //
+    IntPrioritySet(INT_CAN0, OS_KERNEL_PRIORITY << 5);
     IntEnable(INT_CAN0);
 
     //
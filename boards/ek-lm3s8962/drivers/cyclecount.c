@@ -0,0 +1,38 @@
+//*****************************************************************************
+//
+// Filename: cyclecount.c
+// Description: CPU cycle counter for benchmarks, read from the DWT.  A
+//   debugger may already have turned the counter on, so Cycle_Init only
+//   sets the enable bits and never clears the count.
+// Hardware Configuration:
+//   DWT CYCCNT, enabled through TRCENA in the debug monitor control register
+//
+//*****************************************************************************
+
+#include "inc/hw_types.h"
+#include "drivers/cyclecount.h"
+
+#define DEMCR 0xE000EDFC            // debug exception and monitor control
+#define DEMCR_TRCENA 0x01000000     // enables the DWT and ITM
+#define DWT_CTRL 0xE0001000         // DWT control
+#define DWT_CTRL_CYCCNTENA 0x00000001
+#define DWT_CYCCNT 0xE0001004       // cycle count
+
+// *********** Cycle_Init ************
+// Starts the cycle counter.  Calling it again does nothing.
+// Inputs: none
+// Outputs: none
+void Cycle_Init(void)
+{
+  HWREG(DEMCR) |= DEMCR_TRCENA;
+  HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
+
+// *********** Cycle_Count ************
+// Reads the cycle counter.
+// Inputs: none
+// Outputs: cycles, counting up
+unsigned long Cycle_Count(void)
+{
+  return HWREG(DWT_CYCCNT);
+}
@@ -0,0 +1,29 @@
+//*****************************************************************************
+//
+// Filename: cyclecount.h
+// Description: CPU cycle counter for benchmarks.  Reads the DWT cycle
+//   counter of the Cortex-M3, which counts every core clock and wraps
+//   every 85.9 s at 50 MHz.  Unlike the timebase it needs no interrupt and
+//   costs one load to read.
+// Hardware Configuration:
+//   DWT CYCCNT, enabled through TRCENA in the debug monitor control register
+//
+//*****************************************************************************
+
+#ifndef CYCLECOUNT
+#define CYCLECOUNT
+
+// *********** Cycle_Init ************
+// Starts the cycle counter.  Calling it again does nothing.
+// Inputs: none
+// Outputs: none
+void Cycle_Init(void);
+
+// *********** Cycle_Count ************
+// Reads the cycle counter.  Counts up, so the difference of two readings
+// is the elapsed time in cycles.
+// Inputs: none
+// Outputs: cycles
+unsigned long Cycle_Count(void);
+
+#endif
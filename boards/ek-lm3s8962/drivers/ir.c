@@ -28,6 +28,10 @@ extern unsigned long DataLost;     // data sent by Producer, but not received by
 extern unsigned long PIDWork;      // current number of PID calculations finished
 extern unsigned long FilterWork;   // number of digital filter calculations finished
 extern struct sensors Sensors;
+
+// One flag per sensor, set when its raw FIFO has data
+FlagsType IRFlags;
+
 //*************GetIR***************
 // Background thread for IR sensor,
 // called when ADC finishes a conversion
@@ -38,6 +42,7 @@ void GetIR0(unsigned short data){
   } else{ 
     DataLost++;
   } 
+  OS_SetFlags(&IRFlags, IR_FLAG(0));
 }
 
 //*************GetIR***************
@@ -50,6 +55,7 @@ void GetIR1(unsigned short data){
   } else{ 
     DataLost++;
   } 
+  OS_SetFlags(&IRFlags, IR_FLAG(1));
 }
 //*************GetIR***************
 // Background thread for IR sensor,
@@ -61,6 +67,7 @@ void GetIR2(unsigned short data){
   } else{ 
     DataLost++;
   } 
+  OS_SetFlags(&IRFlags, IR_FLAG(2));
 }
 //*************GetIR***************
 // Background thread for IR sensor,
@@ -72,6 +79,7 @@ void GetIR3(unsigned short data){
   } else{ 
     DataLost++;
   } 
+  OS_SetFlags(&IRFlags, IR_FLAG(3));
 }
 
 //************IR DAQ thread********
@@ -90,12 +98,17 @@ void IRSensor0(void){
   unsigned short max,min;
   
 
+  // IRSensor0 is added before the other sensor threads, so the flags are
+  // set up before any of them waits on them
+  OS_InitFlags(&IRFlags, 0);
   ADC_Collect_All(IR_SAMPLING_RATE, &GetIR0, &GetIR1, &GetIR2, &GetIR3); //ADC sample on channel 0, 20Hz
   
   for(;;){
 	data[2] = data[1];
 	data[1] = data[0];
-    while(!RawIR0_Fifo_Get(&ADCin));
+    while(!RawIR0_Fifo_Get(&ADCin)){
+      OS_WaitFlags(&IRFlags, IR_FLAG(0), FLAGS_ANY|FLAGS_CLEAR);
+    }
 	if(ADCin < 22){ADCin = 22;}
 	data[0] = ((long)ADCin*7836 - 166052)/1024; //((1/cm)*65535) = ((7836*x-166052)/1024
 	data[0] = 65535/data[0];  //cm = 65535/data[0] from last operation
@@ -171,7 +184,9 @@ void IRSensor1(void){
   for(;;){
 	data[2] = data[1];
 	data[1] = data[0];
-    while(!RawIR1_Fifo_Get(&ADCin));
+    while(!RawIR1_Fifo_Get(&ADCin)){
+      OS_WaitFlags(&IRFlags, IR_FLAG(1), FLAGS_ANY|FLAGS_CLEAR);
+    }
 	if(ADCin < 22){ADCin = 22;}
 	data[0] = ((long)ADCin*7836 - 166052)/1024; //((1/cm)*65535) = ((7836*x-166052)/1024
 	data[0] = 65535/data[0];  //cm = 65535/data[0] from last operation
@@ -247,7 +262,9 @@ void IRSensor2(void){
   for(;;){
 	data[2] = data[1];
 	data[1] = data[0];
-    while(!RawIR2_Fifo_Get(&ADCin));
+    while(!RawIR2_Fifo_Get(&ADCin)){
+      OS_WaitFlags(&IRFlags, IR_FLAG(2), FLAGS_ANY|FLAGS_CLEAR);
+    }
 	if(ADCin < 22){ADCin = 22;}
 	data[0] = ((long)ADCin*7836 - 166052)/1024; //((1/cm)*65535) = ((7836*x-166052)/1024
 	data[0] = 65535/data[0];  //cm = 65535/data[0] from last operation
@@ -322,7 +339,9 @@ void IRSensor3(void){
   for(;;){
 	data[2] = data[1];
 	data[1] = data[0];
-    while(!RawIR3_Fifo_Get(&ADCin));
+    while(!RawIR3_Fifo_Get(&ADCin)){
+      OS_WaitFlags(&IRFlags, IR_FLAG(3), FLAGS_ANY|FLAGS_CLEAR);
+    }
 	if(ADCin < 22){ADCin = 22;}
 	data[0] = ((long)ADCin*7836 - 166052)/1024; //((1/cm)*65535) = ((7836*x-166052)/1024
 	data[0] = 65535/data[0];  //cm = 65535/data[0] from last operation
@@ -15,6 +15,7 @@ void GetIR(unsigned short data);
 // data in FIFO, filters data,
 // sends data through CAN. 
 #define IR_SAMPLING_RATE	20               // in Hz
+#define IR_FLAG(n) (1ul << (n))          // IRFlags flag of sensor n, set by GetIRn
 struct IR_STATS{
   short average;
   short stdev;
@@ -11,22 +11,22 @@
 #include "driverlib/can.h"
 #include <string.h>
 #include "math.h"
+#include "drivers/timebase.h"
 
 
 
 
 #define SYSCTL_RCGC2_R     (*((volatile unsigned long *)0x400FE108)) 
 #define GPIOA_AFSEL_R		(*((volatile unsigned long *)0x40004420)) 
-#define FIVE_USEC 125 //Uses a 40 ns clock period
+#define FIVE_USEC TIMEBASE_US(5) //in timebase ticks
 #define PIN_6_WRITE 0x40 
 #define PIN_5_WRITE 0x20
-#define MAX_16_BIT_TCNT 0xFFFF
 #define NUMBER_OF_INCS_IN_USEC 25 
 #define SPEED_OF_SOUND 34029 //speed of sound in 10 nm/us units
 #define NUMBER_OF_NM_IN_MM 1000000
 #define CCP1_TIMER_PRESCALE 0
 #define MAX_DISTANCE 3000
-#define PING_PERIOD 50000 //This is in units of 2000 ns increments
+#define PING_PERIOD TIMEBASE_MS(100) //100 ms in clock cycles
 #define CAN_FIFO_SIZE           (8 * 5)
 
 unsigned long Ping_Data_Lost = 0;
@@ -44,37 +44,6 @@ void CAN_Send(unsigned char *data);
 
 
 
-unsigned long OS_Time(void)
-{
-  return TimerValueGet(TIMER1_BASE, TIMER_B);
-}
-
-
-
-
-
-
-
-//***********************************************************************
-//
-// OS_TimeDifference returns the time difference in usec.
-// inputs: "time1" is the second time, "time2" is the first time
-// outputs: returns the difference between "time1" and "time2"
-//
-//***********************************************************************
-long OS_TimeDifference(unsigned long time1, unsigned long time2)
-//                                   thisTime          	  LastTime
-{
-  if(time2 >= time1)
-  {
-  	return (long)(time2-time1);
-  }
-  else
-  {
-    return (long)(time2 + (MAX_16_BIT_TCNT-time1));      
-  } 
-}
-
 
 
 //*****************************************************************************
@@ -93,6 +62,7 @@ long OS_TimeDifference(unsigned long time1, unsigned long time2)
 static unsigned char fallingEdge = 0;
 unsigned short risingEdgeTime = 0;
 unsigned short fallingEdgeTime = 0;
+unsigned long risingEdgeStamp = 0;   // timebase at the rising edge
 
 
 struct buf_st {
@@ -278,8 +248,6 @@ void pingConsumer(void)  //make this an interrupt
 
 
 
-unsigned long NumOfWrapArounds = 0;
-
 // ******** pingProducer ************
 // Starts a Ping distance measurement
 // by the Ping sensor
@@ -287,21 +255,19 @@ unsigned long NumOfWrapArounds = 0;
 // Outputs: none
 void pingProducer(void)
 {
-	unsigned long startTime = OS_Time();
-	unsigned long endTime = OS_Time();
+	unsigned long startTime = Timebase_Now();
+	unsigned long endTime = Timebase_Now();
 
 	pingConsumer();
 
-	TimerIntClear(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
-
 	//send a 5 us pulse	on PA6
 	GPIODirModeSet(GPIO_PORTA_BASE, GPIO_PIN_6, GPIO_DIR_MODE_OUT);
 
 	IntMasterDisable();
 	GPIOPinWrite(GPIO_PORTA_BASE, GPIO_PIN_6, PIN_6_WRITE);
-	while ( OS_TimeDifference(endTime, startTime) < FIVE_USEC)
+	while ((endTime - startTime) < FIVE_USEC)
 	{
-		endTime = OS_Time();
+		endTime = Timebase_Now();
 	}
 	GPIOPinWrite(GPIO_PORTA_BASE, GPIO_PIN_6, 0);
 	IntMasterEnable();
@@ -355,16 +321,6 @@ void pingProducer(void)
 
 
 
-void PingTimer1BHandler(void)
-{
-	 TimerIntClear(TIMER1_BASE,  TIMER_TIMB_TIMEOUT);
-	 NumOfWrapArounds++;
-}
-
-
-
-
-
 
 // ******** pingInterruptHandler ************
 // Called by input capture interrupts created by
@@ -376,6 +332,7 @@ void pingInterruptHandler(void)
 {
 	unsigned long pulseWidth = 0;
 	unsigned char dataPutFlag = 0;
+	unsigned long captureDiff, stampDiff, wraps;
 
 	//Acknowledge interrupt
 	TimerIntClear(TIMER0_BASE, TIMER_CAPB_EVENT);
@@ -388,21 +345,8 @@ void pingInterruptHandler(void)
 	if (!fallingEdge)
 	{
 		risingEdgeTime = TimerValueGet(TIMER0_BASE, TIMER_B);
+		risingEdgeStamp = Timebase_Now();
 		GPIOPinWrite(GPIO_PORTA_BASE, GPIO_PIN_5, PIN_5_WRITE);	
-
-
-		//make Timer 1B cause a timeout interrupt
-		TimerDisable(TIMER1_BASE, TIMER_B);
-		TimerIntEnable(TIMER1_BASE, TIMER_TIMB_TIMEOUT);
-		TimerLoadSet(TIMER1_BASE, TIMER_B, MAX_16_BIT_TCNT);
-
-
-		//Enable timer 1B and its interrupts
-		IntEnable(INT_TIMER1B);
-		TimerEnable(TIMER1_BASE, TIMER_B);
-
-		//Clear wrap-arounds
-		NumOfWrapArounds = 0;
 	}
 	else //else get falling edge time, reset falling edge flag, and return pulse width
 	{
@@ -410,20 +354,13 @@ void pingInterruptHandler(void)
 		GPIOPinWrite(GPIO_PORTA_BASE, GPIO_PIN_5, 0);
 	
 
-		//Give the time difference (aka pulse width) to the consumer through a FIFO
-		//The following code is derived from the OS_TimeDifference code created
-		//by Dustin Replogle and Katy Loeffler
-		if(risingEdgeTime >= fallingEdgeTime)
-	    {
-	  		pulseWidth =  (long)(risingEdgeTime-fallingEdgeTime);
-	    }
-	    else
-	    {
-	    	pulseWidth =  (long)(risingEdgeTime + (MAX_16_BIT_TCNT-fallingEdgeTime));      
-	    }
-		
-
-		pulseWidth = pulseWidth + (NumOfWrapArounds * MAX_16_BIT_TCNT);
+		//Give the time difference (aka pulse width) to the consumer through a FIFO.
+		//The capture timer is 16 bits, so the number of times it wrapped is taken
+		//from the timebase, which counts the same clock.
+		captureDiff = (unsigned short)(risingEdgeTime - fallingEdgeTime);
+		stampDiff = Timebase_Now() - risingEdgeStamp;
+		wraps = (stampDiff - captureDiff + 0x8000) >> 16;
+		pulseWidth = captureDiff + (wraps << 16);
 		
 		 
 		dataPutFlag	= Ping_Fifo_Put(pulseWidth);
@@ -444,37 +381,39 @@ void pingInterruptHandler(void)
 }
 
 
-#define PING_TIMER_PRESCALE 49
-
+// ******** Ping_TimerIntHandler ************
+// Timer3A interrupt handler, starts a measurement
+// every PING_PERIOD.
+// Inputs: none
+// Outputs: none
+void Ping_TimerIntHandler(void)
+{
+	TimerIntClear(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
+	pingProducer();
+}
 
 
 // ******** Ping_Init ************
 // Initializes all timers and ports that
 // are related to the Ping sensor.
-// Inputs: "periodicTimer" is the timer used for the periodic interrupt
-// that calls pingProducer. "subTimer" is the sub-timer used for the periodic
-// interrupt that calls pingProducer.
+// Timer3A starts a measurement every PING_PERIOD, so this is for
+// boards that do not run the OS, whose periodic thread service owns
+// Timer3A.  Those call pingProducer from a periodic thread instead.
+// Inputs: "priority" is the NVIC priority of the Timer3A interrupt
+// that calls pingProducer, 0 to 7.
 // Outputs: none
-void Ping_Init(unsigned long periodicTimer, unsigned long subTimer)
+void Ping_Init(unsigned long priority)
 {
 	unsigned long delay;
-	unsigned char priority;
 
 	 //Initialize timer 0 so that input capture can be used
- 	 SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
-
-	 //Initialize timer 1 so that OS_Time can be used
-	 // Enable Timer1 module
- 	 SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER1);
-
- 	 // Configure Timer1 as a 16-bit periodic timer.
- 	 TimerConfigure(TIMER1_BASE, TIMER_CFG_B_PERIODIC);
- 	 TimerLoadSet(TIMER1_BASE, TIMER_B, MAX_16_BIT_TCNT);
+	 SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
 
-	 TimerEnable(TIMER1_BASE, TIMER_B);
+	 //Start the timebase used to time the trigger pulse and count capture wraps
+	 Timebase_Init();
 
 	SysCtlClockSet(SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_8MHZ);
-	SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER2);
+	SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER3);
 	//Initialize Ping FIFO
 	Ping_Fifo_Init();
 
@@ -490,23 +429,18 @@ void Ping_Init(unsigned long periodicTimer, unsigned long subTimer)
 	GPIODirModeSet(GPIO_PORTA_BASE, GPIO_PIN_5, GPIO_DIR_MODE_OUT);
 	GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_5, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD);
 
-	//Set prescale of periodic timers
-	TimerPrescaleSet(periodicTimer, subTimer, PING_TIMER_PRESCALE);
-	TimerConfigure(TIMER2_BASE, TIMER_CFG_16_BIT_PAIR | TIMER_CFG_A_PERIODIC | TIMER_CFG_B_PERIODIC);
-	TimerLoadSet(TIMER2_BASE, TIMER_A, PING_PERIOD); 
+	//Start a measurement every PING_PERIOD on Timer3A, 32 bits wide
+	//so the 100 ms period needs no prescale
+	TimerDisable(TIMER3_BASE, TIMER_A);
+	TimerConfigure(TIMER3_BASE, TIMER_CFG_32_BIT_PER);
+	TimerLoadSet(TIMER3_BASE, TIMER_A, PING_PERIOD - 1);
 	
 	//Set timer to interrupt and set priority
-	IntEnable(INT_TIMER2A);
-	priority = 0;
-	priority = priority << 5;
-	IntPrioritySet(INT_TIMER2A, priority);
-	TimerIntEnable(TIMER2_BASE, TIMER_TIMA_TIMEOUT); 
+	TimerIntClear(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
+	TimerIntEnable(TIMER3_BASE, TIMER_TIMA_TIMEOUT); 
+	IntPrioritySet(INT_TIMER3A, priority << 5);
+	IntEnable(INT_TIMER3A);
 
 	//Enable the timer    
-	TimerEnable(TIMER2_BASE, TIMER_A);	
-
-		
-
-
+	TimerEnable(TIMER3_BASE, TIMER_A);	
 }
-
@@ -2,11 +2,21 @@
 // ******** Ping_Init ************
 // Initializes all timers and ports that
 // are related to the Ping sensor.
-// Inputs: "periodicTimer" is the timer used for the periodic interrupt
-// that calls pingProducer. "subTimer" is the sub-timer used for the periodic
-// interrupt that calls pingProducer.
+// Timer3A starts a measurement every PING_PERIOD, so this is for
+// boards that do not run the OS, whose periodic thread service owns
+// Timer3A.  Those call pingProducer from a periodic thread instead.
+// Inputs: "priority" is the NVIC priority of the Timer3A interrupt
+// that calls pingProducer, 0 to 7.
 // Outputs: none
-void Ping_Init(unsigned long periodicTimer, unsigned long subTimer);
+void Ping_Init(unsigned long priority);
+
+
+// ******** Ping_TimerIntHandler ************
+// Timer3A interrupt handler, starts a measurement
+// every PING_PERIOD.
+// Inputs: none
+// Outputs: none
+void Ping_TimerIntHandler(void);
 
 
 
@@ -489,7 +489,7 @@ RIT128x96x4Clear(void)
         }
     }
 }
-Sema4Type oLEDFree;
+MutexType oLEDFree;
 //*****************************************************************************
 // Displays a message on the top or bottom of the display
 // \param device specifies the top (device = 0) or bottom (device = 1) display
@@ -502,7 +502,7 @@ Sema4Type oLEDFree;
 //  Written by: Katy Loeffler 1/22/2011
 //*****************************************************************************
 void oLED_Message(int device, int line, char *string, long value){
-  OS_bWait(&oLEDFree);
+  OS_MutexLock(&oLEDFree);
 
   if(!device){        // top display
   	if(line < 5){    // check bounds for vertical space
@@ -531,7 +531,7 @@ void oLED_Message(int device, int line, char *string, long value){
   	}
   }  
 
-  OS_bSignal(&oLEDFree);
+  OS_MutexUnlock(&oLEDFree);
 
 }
 
@@ -861,7 +861,7 @@ RIT128x96x4Init(unsigned long ulFrequency)
 {
    
   unsigned long ulIdx;
-  OS_InitSemaphore(&oLEDFree, 1);
+  OS_InitMutex(&oLEDFree);
   //
   // Enable the SSI0 and GPIO port blocks as they are needed by this driver.
   //
@@ -34,8 +34,6 @@
 long SRSave (void);
 void SRRestore(long sr);
 
-#define OS_ENTERCRITICAL(){sr = SRSave();}
-#define OS_EXITCRITICAL(){SRRestore(sr);}
 #define CAN_FIFO_SIZE           (8 * 8)
 
 #define _TACH_STATS	0
@@ -189,7 +187,7 @@ void Tach_Init(unsigned long priority){
 	//Enable port interrupt in NVIC
 	IntEnable(INT_TIMER0A);
 	IntEnable(INT_TIMER1A);				 
-	IntPrioritySet(INT_TIMER1B, priority << 5);
+	IntPrioritySet(INT_TIMER0A, priority << 5);
 	IntPrioritySet(INT_TIMER1A, priority << 5);
 	//
 
@@ -0,0 +1,95 @@
+//*****************************************************************************
+//
+// Filename: timebase.c
+// Description: System timebase.  GPTimer2 counts down from 0xFFFFFFFF at
+//   the system clock, its wraps are counted in TimebaseHigh to extend it
+//   to 64 bits.  OS_Time, the kernel trace, the periodic thread service
+//   and the Ping driver all read time from here.
+// Hardware Configuration:
+//   GPTimer2 - 32-bit periodic, counts the 50 MHz system clock
+//
+//*****************************************************************************
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_timer.h"
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "drivers/timebase.h"
+
+volatile unsigned long TimebaseHigh;   // upper 32 bits of the timebase
+unsigned char TimebaseStarted;
+
+// *********** Timebase_Init ************
+// Starts the timebase.  Calling it again does nothing.
+// Inputs: none
+// Outputs: none
+void Timebase_Init(void)
+{
+  if(TimebaseStarted)
+  {
+    return;
+  }
+  TimebaseStarted = 1;
+  TimebaseHigh = 0;
+
+  SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER2);
+  TimerDisable(TIMER2_BASE, TIMER_A);
+  TimerConfigure(TIMER2_BASE, TIMER_CFG_32_BIT_PER);
+  TimerLoadSet(TIMER2_BASE, TIMER_A, 0xFFFFFFFF);
+  TimerIntClear(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
+  TimerIntEnable(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
+  IntPrioritySet(INT_TIMER2A, 0);
+  IntEnable(INT_TIMER2A);
+  TimerEnable(TIMER2_BASE, TIMER_A);
+}
+
+// *********** Timebase_Now ************
+// Reads the low 32 bits of the timebase.
+// Inputs: none
+// Outputs: ticks, counting up
+unsigned long Timebase_Now(void)
+{
+  return 0xFFFFFFFF - HWREG(TIMER2_BASE + TIMER_O_TAR);
+}
+
+// *********** Timebase_Ticks ************
+// Reads the whole 64-bit timebase.  If the timer has wrapped but the
+// wrap has not been counted yet (interrupts are off, or a higher priority
+// handler is running) the pending interrupt is counted here.
+// Inputs: none
+// Outputs: ticks since Timebase_Init
+unsigned long long Timebase_Ticks(void)
+{
+  unsigned long high;
+  unsigned long low;
+  unsigned long pending;
+
+  // Timer2A is not masked by OS critical sections, so the wrap may be
+  // counted at any point here.  Read it all again if it was.
+  do
+  {
+    high = TimebaseHigh;
+    low = Timebase_Now();
+    pending = HWREG(TIMER2_BASE + TIMER_O_RIS) & TIMER_TIMA_TIMEOUT;
+  }
+  while(high != TimebaseHigh);
+
+  if(pending && (low < 0x80000000))
+  {
+    high++;
+  }
+  return ((unsigned long long)high << 32) | low;
+}
+
+// *********** Timebase_IntHandler ************
+// Timer2A interrupt handler, counts the wraps of the hardware timer.
+// Inputs: none
+// Outputs: none
+void Timebase_IntHandler(void)
+{
+  TimerIntClear(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
+  TimebaseHigh++;
+}
@@ -0,0 +1,54 @@
+//*****************************************************************************
+//
+// Filename: timebase.h
+// Description: System timebase.  GPTimer2 runs free at the system clock and
+//   is extended to 64 bits in software, so every module stamps time on
+//   the same clock.  Timer2 belongs to this module and must not be
+//   reconfigured by anyone else.
+// Hardware Configuration:
+//   GPTimer2 - 32-bit periodic, counts the 50 MHz system clock
+//
+//*****************************************************************************
+
+#ifndef TIMEBASE
+#define TIMEBASE
+
+#define TIMEBASE_TICKS_PER_US 50		// ticks are 20 ns
+#define TIMEBASE_TICKS_PER_MS 50000
+
+// Conversions between ticks and time, none of them divide.  The tick to
+// time conversions multiply by a rounded up reciprocal, which gives the
+// same result as dividing for every 32-bit tick count.
+#define TIMEBASE_US(us) ((unsigned long)(us)*TIMEBASE_TICKS_PER_US)
+#define TIMEBASE_MS(ms) ((unsigned long)(ms)*TIMEBASE_TICKS_PER_MS)
+#define TIMEBASE_TO_US(ticks) \
+  ((unsigned long)(((unsigned long long)(unsigned long)(ticks)*2748779070UL) >> 37))
+#define TIMEBASE_TO_MS(ticks) \
+  ((unsigned long)(((unsigned long long)TIMEBASE_TO_US(ticks)*68719477UL) >> 36))
+
+// *********** Timebase_Init ************
+// Starts the timebase.  Calling it again does nothing.
+// Inputs: none
+// Outputs: none
+void Timebase_Init(void);
+
+// *********** Timebase_Now ************
+// Reads the low 32 bits of the timebase.  Counts up and wraps every
+// 85.9 s, so the difference of two readings is the elapsed time in ticks.
+// Inputs: none
+// Outputs: ticks
+unsigned long Timebase_Now(void);
+
+// *********** Timebase_Ticks ************
+// Reads the whole 64-bit timebase, which does not wrap.
+// Inputs: none
+// Outputs: ticks since Timebase_Init
+unsigned long long Timebase_Ticks(void);
+
+// *********** Timebase_IntHandler ************
+// Timer2A interrupt handler, counts the wraps of the hardware timer.
+// Inputs: none
+// Outputs: none
+void Timebase_IntHandler(void);
+
+#endif
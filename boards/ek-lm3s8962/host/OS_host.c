@@ -0,0 +1,625 @@
+//*****************************************************************************
+//
+// Filename: OS_host.c
+// Description: Host port of the kernel.  This file stands in for OS_asm.s
+// and for the Cortex-M3 core, so drivers/OS.c and the rest of the kernel
+// run unchanged as a Linux program.
+//
+// Every thread runs on a ucontext with a host stack of its own.  StackInit
+// returns a pointer to the context, which the TCB keeps in stackPtr, and
+// PendSVHandler swaps contexts.  The idle thread's WFI is pause().
+// PRIMASK and BASEPRI are flags, since SysTick and GPTimer3A both run at
+// or below OS_KERNEL_PRIORITY and any critical section masks them.  They are POSIX timers that raise SIGRTMIN,
+// and the signal handler runs the kernel's interrupt handler if interrupts
+// are enabled or leaves it pending if they are not.  Pending interrupts and PendSV run as soon as interrupts
+// are enabled again, as they would on the board.  The timebase counts
+// CLOCK_MONOTONIC in 20 ns cycles, so OS_Time and every period keep the
+// board's units.  The benchmark cycle counter reads CLOCK_MONOTONIC in
+// nanoseconds.
+//
+// Interrupt handlers do not preempt each other, and everything runs on a
+// single Linux thread.  This file runs on the development PC, not on the
+// board.  See host/testmain.c for how to build.
+//
+//*****************************************************************************
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "inc/hw_nvic.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/systick.h"
+#include "driverlib/timer.h"
+#include "drivers/OS.h"
+#include "drivers/cyclecount.h"
+#include "drivers/timebase.h"
+#include "host/OS_host.h"
+
+//***********************************************************************
+//
+// MACROS
+//
+//***********************************************************************
+#define HOST_CONTEXTS (MAX_NUM_OS_THREADS+1)  // a killed thread may still be running
+#define HOST_REGS 32            // registers that HWREG may touch
+
+// Interrupts the host raises, in the order they are taken
+#define HOST_IRQ_SYSTICK 0
+#define HOST_IRQ_TIMER3A 1
+#define HOST_IRQ_STOP 2         // end of Host_RunFor
+#define HOST_NUM_IRQS 3
+
+typedef struct HostContext{
+  ucontext_t context;
+  void(*task)(void);
+  unsigned char stack[HOST_STACK_SIZE];
+}HostContext;
+
+extern TCB * CurrentThread;
+extern TCB * NextThread;
+extern struct tcb OSThreads[MAX_NUM_OS_THREADS];
+extern void SysTickThSwIntHandler(void);
+extern void Timer3AIntHandler(void);
+extern void PendSVSchedule(void);
+void PendSVHandler(void);
+static void HostStop(void);
+
+//***********************************************************************
+//
+// Global Variables
+//
+//***********************************************************************
+HostContext HostContexts[HOST_CONTEXTS];
+volatile sig_atomic_t HostPrimask;        // 1 while interrupts are disabled
+volatile sig_atomic_t HostBasepri;        // OS_BASEPRI in a critical section
+volatile sig_atomic_t HostHandlerMode;    // 1 while an interrupt handler runs
+volatile sig_atomic_t HostPending[HOST_NUM_IRQS];
+unsigned char HostEnabled[HOST_NUM_IRQS];
+void(* const HostHandlers[HOST_NUM_IRQS])(void) =
+{
+  SysTickThSwIntHandler,
+  Timer3AIntHandler,
+  HostStop
+};
+volatile unsigned long HostIntCtrl;       // NVIC_INT_CTRL
+unsigned long HostRegAddr[HOST_REGS];
+volatile unsigned long HostRegs[HOST_REGS];
+int HostNumRegs;
+unsigned char HostStarted;
+struct timespec HostEpoch;                // the timebase is 0 here
+timer_t HostTimers[HOST_NUM_IRQS];
+unsigned long HostSysTickPeriod;
+unsigned long HostTimer3Config;
+unsigned long HostTimer3Load;
+int(*HostReport)(void);
+
+//***********************************************************************
+//
+// HostWaiting returns true if an enabled interrupt or PendSV is pending.
+//
+//***********************************************************************
+static int
+HostWaiting(void)
+{
+  int irq;
+
+  for(irq = 0; irq < HOST_NUM_IRQS; irq++)
+  {
+    if(HostPending[irq] && HostEnabled[irq])
+    {
+      return 1;
+    }
+  }
+  return (HostIntCtrl & NVIC_INT_CTRL_PEND_SV) && (CurrentThread != NULL);
+}
+
+//***********************************************************************
+//
+// HostDispatch runs the pending interrupt handlers, then PendSV.  It is
+// called when interrupts are enabled in thread mode, and from the signal
+// handler.  PendSV may switch threads, this call then returns when the
+// thread that made it runs again.
+//
+//***********************************************************************
+static void
+HostDispatch(void)
+{
+  int irq;
+
+  do
+  {
+    HostHandlerMode = 1;
+    for(irq = 0; irq < HOST_NUM_IRQS; irq++)
+    {
+      if(HostPending[irq] && HostEnabled[irq])
+      {
+        HostPending[irq] = 0;
+        HostHandlers[irq]();
+      }
+    }
+    if((HostIntCtrl & NVIC_INT_CTRL_PEND_SV) && (CurrentThread != NULL))
+    {
+      HostIntCtrl &= ~NVIC_INT_CTRL_PEND_SV;
+      PendSVHandler();
+    }
+    HostHandlerMode = 0;
+  }
+  while(HostWaiting());
+}
+
+//***********************************************************************
+//
+// HostEnableInterrupts clears PRIMASK.  In thread mode the interrupts that
+// came in while it or BASEPRI was set are taken once both are clear.
+//
+//***********************************************************************
+static void
+HostEnableInterrupts(void)
+{
+  HostPrimask = 0;
+  if(!HostBasepri && !HostHandlerMode && HostWaiting())
+  {
+    HostDispatch();
+  }
+}
+
+//***********************************************************************
+//
+// HostSignal is the SIGRTMIN handler, the interrupt request line.
+//
+//***********************************************************************
+static void
+HostSignal(int sig, siginfo_t * info, void * unused)
+{
+  int savedErrno = errno;
+
+  HostPending[info->si_value.sival_int] = 1;
+  if(!HostPrimask && !HostBasepri && !HostHandlerMode)
+  {
+    HostDispatch();
+  }
+  errno = savedErrno;
+}
+
+//***********************************************************************
+//
+// HostStart sets the timebase to 0 and creates a POSIX timer for each
+// interrupt.
+//
+//***********************************************************************
+static void
+HostStart(void)
+{
+  struct sigaction action;
+  struct sigevent event;
+  int irq;
+
+  if(HostStarted)
+  {
+    return;
+  }
+  HostStarted = 1;
+  clock_gettime(CLOCK_MONOTONIC, &HostEpoch);
+
+  action.sa_sigaction = HostSignal;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGRTMIN, &action, NULL);
+
+  for(irq = 0; irq < HOST_NUM_IRQS; irq++)
+  {
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGRTMIN;
+    event.sigev_value.sival_int = irq;
+    if(timer_create(CLOCK_MONOTONIC, &event, &HostTimers[irq]) != 0)
+    {
+      perror("timer_create");
+      exit(1);
+    }
+  }
+}
+
+//***********************************************************************
+//
+// HostArm starts the timer of an interrupt, stopped if cycles is 0.
+//
+//***********************************************************************
+static void
+HostArm(int irq, unsigned long cycles, int periodic)
+{
+  struct itimerspec spec;
+  unsigned long long ns = (unsigned long long)cycles*CLOCK_PERIOD;
+
+  HostStart();
+  spec.it_value.tv_sec = ns/1000000000;
+  spec.it_value.tv_nsec = ns%1000000000;
+  spec.it_interval.tv_sec = 0;
+  spec.it_interval.tv_nsec = 0;
+  if(periodic)
+  {
+    spec.it_interval = spec.it_value;
+  }
+  timer_settime(HostTimers[irq], 0, &spec, NULL);
+}
+
+//***********************************************************************
+//
+// HostStop is the handler for the end of Host_RunFor.
+//
+//***********************************************************************
+static void
+HostStop(void)
+{
+  fflush(stdout);
+  exit(HostReport());
+}
+
+//***********************************************************************
+//
+// HostContextAlloc returns a context that no thread is using.  A killed
+// thread keeps its context until it has been switched out.
+//
+//***********************************************************************
+static HostContext *
+HostContextAlloc(void)
+{
+  int i, t;
+  unsigned char * ctx;
+  int used;
+
+  for(i = 0; i < HOST_CONTEXTS; i++)
+  {
+    ctx = (unsigned char *)&HostContexts[i];
+    used = (CurrentThread != NULL) && (CurrentThread->stackPtr == ctx);
+    for(t = 0; t < MAX_NUM_OS_THREADS; t++)
+    {
+      if((OSThreads[t].id != DEAD) && (OSThreads[t].stackPtr == ctx))
+      {
+        used = 1;
+      }
+    }
+    if(!used)
+    {
+      return &HostContexts[i];
+    }
+  }
+  fprintf(stderr, "os_host: out of thread contexts\n");
+  abort();
+}
+
+//***********************************************************************
+//
+// HostThreadStart is where every thread starts, in thread mode with
+// interrupts enabled.  On the board a task that returns faults.
+//
+//***********************************************************************
+static void
+HostThreadStart(void)
+{
+  HostHandlerMode = 0;
+  HostEnableInterrupts();
+  ((HostContext *)CurrentThread->stackPtr)->task();
+  fprintf(stderr, "os_host: thread %d returned from its task\n", CurrentThread->id);
+  abort();
+}
+
+//***********************************************************************
+//
+// Replacements for OS_asm.s
+//
+//***********************************************************************
+long
+SRSave(void)
+{
+  long sr = HostBasepri;
+
+  if((sr == 0) || (sr > OS_BASEPRI))
+  {
+    HostBasepri = OS_BASEPRI;
+  }
+  return sr;
+}
+
+void
+SRRestore(long sr)
+{
+  HostBasepri = sr;
+  if(!sr && !HostPrimask && !HostHandlerMode && HostWaiting())
+  {
+    HostDispatch();
+  }
+}
+
+unsigned char *
+StackInit(unsigned char * ThreadStkPtr, void(*task)(void))
+{
+  HostContext * ctx = HostContextAlloc();
+
+  getcontext(&ctx->context);
+  ctx->context.uc_stack.ss_sp = ctx->stack;
+  ctx->context.uc_stack.ss_size = sizeof(ctx->stack);
+  ctx->context.uc_link = NULL;
+  sigemptyset(&ctx->context.uc_sigmask);
+  ctx->task = task;
+  makecontext(&ctx->context, HostThreadStart, 0);
+  return (unsigned char *)ctx;
+}
+
+void
+LaunchInternal(unsigned char * firstStackPtr)
+{
+  setcontext(&((HostContext *)firstStackPtr)->context);
+}
+
+void
+PendSVHandler(void)
+{
+  HostContext * from;
+  HostContext * to;
+
+  PendSVSchedule();
+  from = (HostContext *)CurrentThread->stackPtr;
+  to = (HostContext *)NextThread->stackPtr;
+
+  HostPrimask = 1;
+  CurrentThread = NextThread;
+  if(from != to)
+  {
+    swapcontext(&from->context, &to->context);
+  }
+
+  // Back in PendSV, in the thread that was switched in
+  HostHandlerMode = 1;
+  HostPrimask = 0;
+}
+
+void
+TriggerPendSV(void)
+{
+  HostIntCtrl |= NVIC_INT_CTRL_PEND_SV;
+  if(!HostPrimask && !HostBasepri && !HostHandlerMode)
+  {
+    HostDispatch();
+  }
+}
+
+void
+WaitForInterrupt(void)
+{
+  pause();
+}
+
+//***********************************************************************
+//
+// Host_Reg returns the host copy of a register, for HWREG.  NVIC_INT_CTRL
+// pends PendSV, the others are only memory.
+//
+//***********************************************************************
+volatile unsigned long *
+Host_Reg(unsigned long ulAddr)
+{
+  int i;
+
+  if(ulAddr == NVIC_INT_CTRL)
+  {
+    return &HostIntCtrl;
+  }
+  for(i = 0; i < HostNumRegs; i++)
+  {
+    if(HostRegAddr[i] == ulAddr)
+    {
+      return &HostRegs[i];
+    }
+  }
+  if(HostNumRegs == HOST_REGS)
+  {
+    fprintf(stderr, "os_host: too many registers, 0x%08lx\n", ulAddr);
+    abort();
+  }
+  HostRegAddr[HostNumRegs] = ulAddr;
+  return &HostRegs[HostNumRegs++];
+}
+
+//***********************************************************************
+//
+// Host_RunFor ends the program after ms milliseconds, see OS_host.h.
+//
+//***********************************************************************
+void
+Host_RunFor(unsigned long ms, int(*report)(void))
+{
+  HostReport = report;
+  HostEnabled[HOST_IRQ_STOP] = 1;
+  HostArm(HOST_IRQ_STOP, ms*TIME_1MS, 0);
+}
+
+//***********************************************************************
+//
+// Timebase.  unsigned long is 64 bits on the host, so it does not wrap.
+//
+//***********************************************************************
+void
+Timebase_Init(void)
+{
+  HostStart();
+}
+
+unsigned long long
+Timebase_Ticks(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((unsigned long long)(now.tv_sec - HostEpoch.tv_sec)*1000000000 +
+          now.tv_nsec - HostEpoch.tv_nsec)/CLOCK_PERIOD;
+}
+
+unsigned long
+Timebase_Now(void)
+{
+  return (unsigned long)Timebase_Ticks();
+}
+
+//***********************************************************************
+//
+// Cycle counter.  There is no portable cycle count on the PC, so the
+// benchmarks count nanoseconds instead.
+//
+//***********************************************************************
+void
+Cycle_Init(void)
+{
+}
+
+unsigned long
+Cycle_Count(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long)now.tv_sec*1000000000 + now.tv_nsec;
+}
+
+//***********************************************************************
+//
+// NVIC.  Priorities are ignored, handlers never preempt each other.
+//
+//***********************************************************************
+tBoolean
+IntMasterEnable(void)
+{
+  tBoolean wasDisabled = (tBoolean)HostPrimask;
+
+  HostEnableInterrupts();
+  return wasDisabled;
+}
+
+tBoolean
+IntMasterDisable(void)
+{
+  tBoolean wasDisabled = (tBoolean)HostPrimask;
+
+  HostPrimask = 1;
+  return wasDisabled;
+}
+
+void
+IntEnable(unsigned long ulInterrupt)
+{
+  if(ulInterrupt == INT_TIMER3A)
+  {
+    HostEnabled[HOST_IRQ_TIMER3A] = 1;
+  }
+}
+
+void
+IntDisable(unsigned long ulInterrupt)
+{
+  if(ulInterrupt == INT_TIMER3A)
+  {
+    HostEnabled[HOST_IRQ_TIMER3A] = 0;
+  }
+}
+
+void
+IntPrioritySet(unsigned long ulInterrupt, unsigned char ucPriority)
+{
+}
+
+//***********************************************************************
+//
+// SysTick
+//
+//***********************************************************************
+void
+SysTickPeriodSet(unsigned long ulPeriod)
+{
+  HostSysTickPeriod = ulPeriod;
+}
+
+void
+SysTickEnable(void)
+{
+  HostArm(HOST_IRQ_SYSTICK, HostSysTickPeriod, 1);
+}
+
+void
+SysTickDisable(void)
+{
+  HostArm(HOST_IRQ_SYSTICK, 0, 0);
+}
+
+void
+SysTickIntEnable(void)
+{
+  HostEnabled[HOST_IRQ_SYSTICK] = 1;
+}
+
+void
+SysTickIntDisable(void)
+{
+  HostEnabled[HOST_IRQ_SYSTICK] = 0;
+}
+
+//***********************************************************************
+//
+// GPTimers.  Only Timer3A counts, the others are not used by the kernel.
+//
+//***********************************************************************
+void
+TimerConfigure(unsigned long ulBase, unsigned long ulConfig)
+{
+  if(ulBase == TIMER3_BASE)
+  {
+    HostTimer3Config = ulConfig;
+  }
+}
+
+void
+TimerLoadSet(unsigned long ulBase, unsigned long ulTimer, unsigned long ulValue)
+{
+  if((ulBase == TIMER3_BASE) && (ulTimer & TIMER_A))
+  {
+    HostTimer3Load = ulValue;
+  }
+}
+
+void
+TimerEnable(unsigned long ulBase, unsigned long ulTimer)
+{
+  if((ulBase == TIMER3_BASE) && (ulTimer & TIMER_A))
+  {
+    HostArm(HOST_IRQ_TIMER3A, HostTimer3Load, HostTimer3Config == TIMER_CFG_32_BIT_PER);
+  }
+}
+
+void
+TimerDisable(unsigned long ulBase, unsigned long ulTimer)
+{
+  if((ulBase == TIMER3_BASE) && (ulTimer & TIMER_A))
+  {
+    HostArm(HOST_IRQ_TIMER3A, 0, 0);
+  }
+}
+
+void
+TimerIntEnable(unsigned long ulBase, unsigned long ulIntFlags)
+{
+}
+
+void
+TimerIntDisable(unsigned long ulBase, unsigned long ulIntFlags)
+{
+}
+
+void
+TimerIntClear(unsigned long ulBase, unsigned long ulIntFlags)
+{
+}
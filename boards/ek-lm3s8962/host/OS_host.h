@@ -0,0 +1,17 @@
+//*****************************************************************************
+//
+// OS_host.h contains the calls a host program adds to a test main.  The
+// kernel itself is unchanged, see host/OS_host.c.
+//
+//*****************************************************************************
+
+#define HOST_STACK_SIZE 65536 		// host stack of each thread, in bytes
+
+// *********** Host_RunFor ************
+// Ends the program after it has run for a while.  Call it before
+// OS_Launch.  When the time is up report runs as an interrupt handler and
+// its return value is the exit status of the program.
+// Inputs: ms is the run time in milliseconds
+//         report prints the results, returns 0 if the test passed
+// Outputs: none
+extern void Host_RunFor(unsigned long ms, int(*report)(void));
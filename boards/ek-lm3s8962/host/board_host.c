@@ -0,0 +1,144 @@
+//*****************************************************************************
+//
+// Filename: board_host.c
+// Description: Host port stand-ins for the board peripherals the kernel
+// touches.  GPIO inputs read high, so the switches are never pressed, and
+// there is no OLED, ADC, CAN bus or SD card.  UART0 is stdout.
+//
+// This file runs on the development PC, not on the board.  See
+// host/testmain.c for how to build.
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include "inc/hw_types.h"
+#include "driverlib/can.h"
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+#include "drivers/OSuart.h"
+#include "drivers/efile.h"
+#include "drivers/rit128x96x4.h"
+
+//***********************************************************************
+//
+// System control
+//
+//***********************************************************************
+void
+SysCtlPeripheralEnable(unsigned long ulPeripheral)
+{
+}
+
+void
+SysCtlClockSet(unsigned long ulConfig)
+{
+}
+
+unsigned long
+SysCtlClockGet(void)
+{
+  return 50000000;
+}
+
+//***********************************************************************
+//
+// GPIO
+//
+//***********************************************************************
+void
+GPIOPinTypeGPIOInput(unsigned long ulPort, unsigned char ucPins)
+{
+}
+
+void
+GPIOPinTypeGPIOOutput(unsigned long ulPort, unsigned char ucPins)
+{
+}
+
+void
+GPIOPadConfigSet(unsigned long ulPort, unsigned char ucPins,
+                 unsigned long ulStrength, unsigned long ulPadType)
+{
+}
+
+long
+GPIOPinRead(unsigned long ulPort, unsigned char ucPins)
+{
+  return ucPins;
+}
+
+void
+GPIOPinWrite(unsigned long ulPort, unsigned char ucPins, unsigned char ucVal)
+{
+}
+
+void
+GPIOPinIntDisable(unsigned long ulPort, unsigned char ucPins)
+{
+}
+
+void
+GPIOPinIntClear(unsigned long ulPort, unsigned char ucPins)
+{
+}
+
+//***********************************************************************
+//
+// CAN
+//
+//***********************************************************************
+void
+CANIntDisable(unsigned long ulBase, unsigned long ulIntFlags)
+{
+}
+
+//***********************************************************************
+//
+// ADC, OLED, UART and file system
+//
+//***********************************************************************
+int
+ADC_Open(void)
+{
+  return 1;
+}
+
+void
+RIT128x96x4Init(unsigned long ulFrequency)
+{
+}
+
+void
+OSuart_Open(void)
+{
+}
+
+void
+OSuart_OutChar(unsigned long ulBase, char string)
+{
+  putchar(string);
+}
+
+void
+OSuart_OutString(unsigned long ulBase, char *string)
+{
+  fputs(string, stdout);
+}
+
+int
+eFile_WOpen(char name[])
+{
+  return 1;
+}
+
+int
+eFile_Write(char data)
+{
+  return 1;
+}
+
+int
+eFile_WClose(void)
+{
+  return 1;
+}
@@ -0,0 +1,26 @@
+//*****************************************************************************
+//
+// can.h - Host port version of the CAN driver.  Implemented in
+// host/board_host.c, there is no bus on the host.
+//
+//*****************************************************************************
+
+#ifndef __CAN_H__
+#define __CAN_H__
+
+#define CAN_INT_ERROR           0x00000008  // Error interrupt
+#define CAN_INT_MASTER          0x00000002  // Master interrupt
+
+typedef struct
+{
+    unsigned long ulMsgID;
+    unsigned long ulMsgIDMask;
+    unsigned long ulFlags;
+    unsigned long ulMsgLen;
+    unsigned char *pucMsgData;
+}
+tCANMsgObject;
+
+extern void CANIntDisable(unsigned long ulBase, unsigned long ulIntFlags);
+
+#endif // __CAN_H__
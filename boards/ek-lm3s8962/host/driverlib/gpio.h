@@ -0,0 +1,37 @@
+//*****************************************************************************
+//
+// gpio.h - Host port version of the GPIO driver.  Implemented in
+// host/board_host.c, inputs read high (switches released) and outputs
+// go nowhere.
+//
+//*****************************************************************************
+
+#ifndef __GPIO_H__
+#define __GPIO_H__
+
+#define GPIO_PIN_0              0x00000001  // GPIO pin 0
+#define GPIO_PIN_1              0x00000002  // GPIO pin 1
+#define GPIO_PIN_2              0x00000004  // GPIO pin 2
+#define GPIO_PIN_3              0x00000008  // GPIO pin 3
+#define GPIO_PIN_4              0x00000010  // GPIO pin 4
+#define GPIO_PIN_5              0x00000020  // GPIO pin 5
+#define GPIO_PIN_6              0x00000040  // GPIO pin 6
+#define GPIO_PIN_7              0x00000080  // GPIO pin 7
+
+#define GPIO_STRENGTH_2MA       0x00000001  // 2mA drive strength
+
+#define GPIO_PIN_TYPE_STD       0x00000008  // Push-pull
+#define GPIO_PIN_TYPE_STD_WPU   0x0000000A  // Push-pull with weak pull-up
+
+extern void GPIOPinTypeGPIOInput(unsigned long ulPort, unsigned char ucPins);
+extern void GPIOPinTypeGPIOOutput(unsigned long ulPort, unsigned char ucPins);
+extern void GPIOPadConfigSet(unsigned long ulPort, unsigned char ucPins,
+                             unsigned long ulStrength,
+                             unsigned long ulPadType);
+extern long GPIOPinRead(unsigned long ulPort, unsigned char ucPins);
+extern void GPIOPinWrite(unsigned long ulPort, unsigned char ucPins,
+                         unsigned char ucVal);
+extern void GPIOPinIntDisable(unsigned long ulPort, unsigned char ucPins);
+extern void GPIOPinIntClear(unsigned long ulPort, unsigned char ucPins);
+
+#endif // __GPIO_H__
@@ -0,0 +1,18 @@
+//*****************************************************************************
+//
+// interrupt.h - Host port version of the NVIC driver.  Implemented in
+// host/OS_host.c.
+//
+//*****************************************************************************
+
+#ifndef __INTERRUPT_H__
+#define __INTERRUPT_H__
+
+extern tBoolean IntMasterEnable(void);
+extern tBoolean IntMasterDisable(void);
+extern void IntEnable(unsigned long ulInterrupt);
+extern void IntDisable(unsigned long ulInterrupt);
+extern void IntPrioritySet(unsigned long ulInterrupt,
+                           unsigned char ucPriority);
+
+#endif // __INTERRUPT_H__
@@ -0,0 +1,34 @@
+//*****************************************************************************
+//
+// sysctl.h - Host port version of the system control driver.  Implemented
+// in host/board_host.c, there is no clock or peripheral to set up.
+//
+//*****************************************************************************
+
+#ifndef __SYSCTL_H__
+#define __SYSCTL_H__
+
+#define SYSCTL_PERIPH_ADC0      0x00100001  // ADC0
+#define SYSCTL_PERIPH_CAN0      0x00100100  // CAN 0
+#define SYSCTL_PERIPH_UART0     0x10000001  // UART 0
+#define SYSCTL_PERIPH_TIMER0    0x10010000  // Timer 0
+#define SYSCTL_PERIPH_TIMER1    0x10020000  // Timer 1
+#define SYSCTL_PERIPH_TIMER2    0x10040000  // Timer 2
+#define SYSCTL_PERIPH_TIMER3    0x10080000  // Timer 3
+#define SYSCTL_PERIPH_GPIOA     0x20000001  // GPIO A
+#define SYSCTL_PERIPH_GPIOB     0x20000002  // GPIO B
+#define SYSCTL_PERIPH_GPIOC     0x20000004  // GPIO C
+#define SYSCTL_PERIPH_GPIOD     0x20000008  // GPIO D
+#define SYSCTL_PERIPH_GPIOE     0x20000010  // GPIO E
+#define SYSCTL_PERIPH_GPIOF     0x20000020  // GPIO F
+
+#define SYSCTL_SYSDIV_4         0x01C00000  // Processor clock is osc/pll /4
+#define SYSCTL_USE_PLL          0x00000000  // System clock is the PLL clock
+#define SYSCTL_OSC_MAIN         0x00000000  // Osc source is main osc
+#define SYSCTL_XTAL_8MHZ        0x00000380  // External crystal is 8MHz
+
+extern void SysCtlPeripheralEnable(unsigned long ulPeripheral);
+extern void SysCtlClockSet(unsigned long ulConfig);
+extern unsigned long SysCtlClockGet(void);
+
+#endif // __SYSCTL_H__
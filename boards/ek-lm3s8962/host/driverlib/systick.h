@@ -0,0 +1,17 @@
+//*****************************************************************************
+//
+// systick.h - Host port version of the SysTick driver.  Implemented in
+// host/OS_host.c.
+//
+//*****************************************************************************
+
+#ifndef __SYSTICK_H__
+#define __SYSTICK_H__
+
+extern void SysTickEnable(void);
+extern void SysTickDisable(void);
+extern void SysTickIntEnable(void);
+extern void SysTickIntDisable(void);
+extern void SysTickPeriodSet(unsigned long ulPeriod);
+
+#endif // __SYSTICK_H__
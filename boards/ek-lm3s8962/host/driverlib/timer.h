@@ -0,0 +1,30 @@
+//*****************************************************************************
+//
+// timer.h - Host port version of the GPTimer driver.  Implemented in
+// host/OS_host.c, only GPTimer3A (the periodic thread service) raises
+// interrupts on the host.
+//
+//*****************************************************************************
+
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#define TIMER_CFG_32_BIT_OS     0x00000001  // 32-bit one-shot timer
+#define TIMER_CFG_32_BIT_PER    0x00000002  // 32-bit periodic timer
+
+#define TIMER_TIMA_TIMEOUT      0x00000001  // TimerA time out interrupt
+
+#define TIMER_A                 0x000000ff  // Timer A
+#define TIMER_B                 0x0000ff00  // Timer B
+#define TIMER_BOTH              0x0000ffff  // Timer Both
+
+extern void TimerEnable(unsigned long ulBase, unsigned long ulTimer);
+extern void TimerDisable(unsigned long ulBase, unsigned long ulTimer);
+extern void TimerConfigure(unsigned long ulBase, unsigned long ulConfig);
+extern void TimerLoadSet(unsigned long ulBase, unsigned long ulTimer,
+                         unsigned long ulValue);
+extern void TimerIntEnable(unsigned long ulBase, unsigned long ulIntFlags);
+extern void TimerIntDisable(unsigned long ulBase, unsigned long ulIntFlags);
+extern void TimerIntClear(unsigned long ulBase, unsigned long ulIntFlags);
+
+#endif // __TIMER_H__
@@ -0,0 +1,14 @@
+//*****************************************************************************
+//
+// hw_nvic.h - Host port version of the NVIC registers the kernel uses.
+//
+//*****************************************************************************
+
+#ifndef __HW_NVIC_H__
+#define __HW_NVIC_H__
+
+#define NVIC_INT_CTRL           0xE000ED04  // Interrupt Control and State
+
+#define NVIC_INT_CTRL_PEND_SV   0x10000000  // PendSV Set Pending
+
+#endif // __HW_NVIC_H__
@@ -0,0 +1,26 @@
+//*****************************************************************************
+//
+// hw_types.h - Host port version of the common types and register access
+// macros.  Registers are not memory on the host, HWREG goes through
+// Host_Reg in host/OS_host.c instead.
+//
+//*****************************************************************************
+
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+typedef unsigned char tBoolean;
+
+#ifndef true
+#define true 1
+#endif
+
+#ifndef false
+#define false 0
+#endif
+
+extern volatile unsigned long * Host_Reg(unsigned long ulAddr);
+
+#define HWREG(x) (*Host_Reg((unsigned long)(x)))
+
+#endif // __HW_TYPES_H__
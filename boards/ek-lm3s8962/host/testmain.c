@@ -0,0 +1,1133 @@
+//*****************************************************************************
+//
+// Filename: testmain.c
+// Description: Lab 2 and Lab 3 test mains for the host port of the kernel,
+// and tests of the kernel services added since.
+// Each one starts the same threads and periodic threads as on the board,
+// runs for a fixed time and then checks the counts in its report.  Button
+// pushes and the OLED are left out, and the busy loops do not toggle GPIO.
+// The counts are volatile so gcc does not keep them in registers, and
+// threads that shared a round robin on the board share a priority here.
+//
+// Every test prints one line of name=value pairs ending in PASS or FAIL,
+// and exits with 0 if it passed, so a kernel change can be checked with:
+//
+//   gcc -O2 -Ihost -I. -I../.. -o os_host host/testmain.c host/OS_host.c
+//       host/board_host.c drivers/OS.c drivers/OS_sched.c drivers/OS_stack.c
+//       drivers/OS_periodic.c drivers/OS_trace.c drivers/OS_pool.c
+//       drivers/OS_defer.c drivers/OS_worker.c
+//   for t in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17; do ./os_host $t || break; done
+//
+// This file runs on the development PC, not on the board.  Build and run
+// from boards/ek-lm3s8962.  ../.. is the StellarisWare root, for
+// driverlib/adc.h and driverlib/fifo.h.
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "drivers/OS.h"
+#include "drivers/OS_pool.h"
+#include "drivers/OS_defer.h"
+#include "drivers/OS_worker.h"
+#include "drivers/OS_periodic.h"
+#include "host/OS_host.h"
+
+#define PASS_FAIL(ok) ((ok) ? "PASS" : "FAIL")
+
+unsigned long NumCreated;   // number of foreground threads created
+unsigned long volatile Count1;   // number of times thread1 loops
+unsigned long volatile Count2;   // number of times thread2 loops
+unsigned long volatile Count3;   // number of times thread3 loops
+unsigned long volatile Count4;   // number of times thread4 loops
+unsigned long volatile Count5;   // number of times thread5 loops
+
+extern TCB * CurrentThread;
+
+//*******************First TEST**********
+// Cooperative multitasking, three threads at one priority take turns
+void Thread1(void){
+  Count1 = 0;
+  for(;;){
+    Count1++;
+    OS_Suspend();      // cooperative multitasking
+  }
+}
+void Thread2(void){
+  Count2 = 0;
+  for(;;){
+    Count2++;
+    OS_Suspend();      // cooperative multitasking
+  }
+}
+void Thread3(void){
+  Count3 = 0;
+  for(;;){
+    Count3++;
+    OS_Suspend();      // cooperative multitasking
+  }
+}
+int Report1(void){
+  // Round robin, no thread gets more than one turn ahead
+  int ok = (Count3 > 0) && (Count1 - Count3 <= 1) && (Count2 - Count3 <= 1);
+  printf("testmain1 Count1=%lu Count2=%lu Count3=%lu NumCreated=%lu %s\n",
+         Count1, Count2, Count3, NumCreated, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain1(void){
+  OS_Init();           // initialize, disable interrupts
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&Thread1,128,1);
+  NumCreated += OS_AddThread(&Thread2,128,1);
+  NumCreated += OS_AddThread(&Thread3,128,1);
+  Host_RunFor(500, &Report1);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Second TEST**********
+// Preemptive time slices and two periodic threads at 2 kHz
+void Thread1b(void){
+  Count1 = 0;
+  for(;;){
+    Count1++;
+  }
+}
+void Thread2b(void){
+  Count2 = 0;
+  for(;;){
+    Count2++;
+  }
+}
+void Thread3b(void){
+  Count3 = 0;
+  for(;;){
+    Count3++;
+  }
+}
+void Dummy1(void){
+  Count4++;
+}
+void Dummy2(void){
+  Count5++;
+}
+int Report2(void){
+  // Thread3b never runs, it is below the other two.  1 s is 2000 releases,
+  // fewer if the PC is busy, since a late host timer skips releases.
+  int ok = (Count1 > 0) && (Count2 > 0) && (Count3 == 0) &&
+           (Count4 > 1500) && (Count4 <= 2000) && (Count5 > 1500) && (Count5 <= 2000);
+  printf("testmain2 Count1=%lu Count2=%lu Count3=%lu Count4=%lu Count5=%lu %s\n",
+         Count1, Count2, Count3, Count4, Count5, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain2(void){
+  OS_Init();           // initialize, disable interrupts
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&Thread1b,128,1);
+  NumCreated += OS_AddThread(&Thread2b,128,1);
+  NumCreated += OS_AddThread(&Thread3b,128,3);
+  OS_AddPeriodicThread(&Dummy1, PERIOD, 1);
+  OS_AddPeriodicThread(&Dummy2, PERIOD, 2);
+  Host_RunFor(1000, &Report2);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Third TEST**********
+// Blocking semaphore signaled at 1 kHz, Sleep and Kill
+Sema4Type Readyc;        // set in background
+long Lost;
+void BackgroundThread1c(void){   // called at 1000 Hz
+  Count1++;
+  OS_Signal(&Readyc);
+}
+void Thread5c(void){
+  for(;;){
+    OS_Wait(&Readyc);
+    Count5++;   // Count2 + Count5 should equal Count1
+    Lost = Count1-Count5-Count2;
+  }
+}
+void Thread2c(void){
+  OS_InitSemaphore(&Readyc,0);
+  Count1 = 0;    // number of times signal is called
+  Count2 = 0;
+  Count5 = 0;    // Count2 + Count5 should equal Count1
+  NumCreated += OS_AddThread(&Thread5c,128,3);
+  OS_AddPeriodicThread(&BackgroundThread1c,TIME_1MS,0);
+  for(;;){
+    OS_Wait(&Readyc);
+    Count2++;   // Count2 + Count5 should equal Count1
+  }
+}
+void Thread3c(void){
+  Count3 = 0;
+  for(;;){
+    Count3++;
+  }
+}
+void Thread4c(void){ int i;
+  for(i=0;i<64;i++){
+    Count4++;
+    OS_Sleep(10);
+  }
+  OS_Kill();
+  Count4 = 0;
+}
+int Report3(void){
+  // Thread2c is above the others, it takes nearly every signal.  Thread5c
+  // only gets one when a late host timer signals twice in a row.
+  int ok = (Count1 > 900) && (Count2 + Count5 + 1 >= Count1) && (Count5*100 < Count1) &&
+           (Count4 == 64) && (NumCreated == 4);
+  printf("testmain3 Count1=%lu Count2=%lu Count5=%lu Count4=%lu NumCreated=%lu %s\n",
+         Count1, Count2, Count5, Count4, NumCreated, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain3(void){
+  Count4 = 0;
+  OS_Init();           // initialize, disable interrupts
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&Thread2c,128,2);
+  NumCreated += OS_AddThread(&Thread3c,128,3);
+  NumCreated += OS_AddThread(&Thread4c,128,3);
+  Host_RunFor(1000, &Report3);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Fourth TEST**********
+// Binary semaphore signaled every 50 ms, Sleep and Kill
+Sema4Type Readyd;        // set in background
+void BackgroundThread1d(void){   // called at 2000 Hz
+static int i=0;
+  i++;
+  if(i==100){
+    i = 0;         //every 50 ms
+    Count1++;
+    OS_bSignal(&Readyd);
+  }
+}
+void Thread2d(void){
+  OS_InitSemaphore(&Readyd,0);
+  Count1 = 0;
+  Count2 = 0;
+  for(;;){
+    OS_bWait(&Readyd);
+    Count2++;
+  }
+}
+void Thread3d(void){
+  Count3 = 0;
+  for(;;){
+    Count3++;
+  }
+}
+void Thread4d(void){ int i;
+  for(i=0;i<640;i++){
+    Count4++;
+    OS_Sleep(1);
+  }
+  OS_Kill();
+}
+int Report4(void){
+  // Thread4d waits a time slice of the busy thread after every sleep, so
+  // it does not finish its 640 loops in the time the test runs
+  int ok = (Count1 >= 18) && (Count2 + 1 >= Count1) && (Count2 <= Count1) &&
+           (Count3 > 0) && (Count4 > 100) && (Count4 <= 640);
+  printf("testmain4 Count1=%lu Count2=%lu Count3=%lu Count4=%lu %s\n",
+         Count1, Count2, Count3, Count4, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain4(void){
+  Count4 = 0;
+  OS_Init();           // initialize, disable interrupts
+  NumCreated = 0 ;
+  OS_AddPeriodicThread(&BackgroundThread1d,PERIOD,0);
+  NumCreated += OS_AddThread(&Thread2d,128,3);   // OS_bWait blocks
+  NumCreated += OS_AddThread(&Thread3d,128,3);
+  NumCreated += OS_AddThread(&Thread4d,128,3);
+  Host_RunFor(1000, &Report4);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Fifth TEST**********
+// Lab 3 Preparation 2, two periodic threads that do real work
+unsigned long volatile CountA;   // number of times Task A called
+unsigned long volatile CountB;   // number of times Task B called
+void PseudoWork(unsigned long work){
+unsigned long startTime;
+  startTime = OS_Time();
+  while(OS_TimeDifference(OS_Time(),startTime) <= (long)work){
+  }
+}
+void Thread6(void){  // foreground thread
+  Count1 = 0;
+  for(;;){
+    Count1++;
+  }
+}
+#define workA 200       // 200 us work in Task A
+#define counts1us 50    // number of OS_Time counts per 1us
+void TaskA(void){       // called every 1.11 ms in background
+  CountA++;
+  PseudoWork(workA*counts1us);
+}
+#define workB 125       // 125 us work in Task B
+void TaskB(void){       // called every 1 ms in background
+  CountB++;
+  PseudoWork(workB*counts1us);
+}
+int Report5(void){
+  // 1 s is 900 releases of TaskA and 1000 of TaskB
+  int ok = (CountA > 700) && (CountA <= 901) && (CountB > 750) && (CountB <= 1000) &&
+           (Count1 > 0);
+  printf("testmain5 CountA=%lu CountB=%lu Count1=%lu JitterA=%ld..%ld JitterB=%ld..%ld %s\n",
+         CountA, CountB, Count1, PeriodicTasks[0].jitter.min, PeriodicTasks[0].jitter.max,
+         PeriodicTasks[1].jitter.min, PeriodicTasks[1].jitter.max, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain5(void){
+  OS_Init();           // initialize, disable interrupts
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&Thread6,128,2);
+  OS_AddPeriodicThread(&TaskA,(TIME_1MS*111)/100,0);  // 1.11 ms, higher priority
+  OS_AddPeriodicThread(&TaskB,TIME_1MS,1);            // 1 ms, lower priority
+  Host_RunFor(1000, &Report5);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Sixth TEST**********
+// Lab 3 Preparation 4, a counting semaphore signaled by two periodic
+// threads and one foreground thread, with three threads waiting.  The
+// foreground signaler is below the waiters so every signal wakes one
+// right away, otherwise it runs the semaphore count past 32767.
+Sema4Type s;            // test of this counting semaphore
+unsigned long volatile SignalCount1;   // number of times s is signaled
+unsigned long volatile SignalCount2;   // number of times s is signaled
+unsigned long volatile SignalCount3;   // number of times s is signaled
+unsigned long volatile WaitCount1;     // number of times s is successfully waited on
+unsigned long volatile WaitCount2;     // number of times s is successfully waited on
+unsigned long volatile WaitCount3;     // number of times s is successfully waited on
+#define MAXCOUNT 20000
+#define SIGNAL3COUNT (5*MAXCOUNT)
+void Wait1(void){  // foreground thread
+  for(;;){
+    OS_Wait(&s);    // three threads waiting
+    WaitCount1++;
+  }
+}
+void Wait2(void){  // foreground thread
+  for(;;){
+    OS_Wait(&s);    // three threads waiting
+    WaitCount2++;
+  }
+}
+void Wait3(void){   // foreground thread
+  for(;;){
+    OS_Wait(&s);    // three threads waiting
+    WaitCount3++;
+  }
+}
+void Signal1(void){      // called every 799us in background
+  if(SignalCount1<MAXCOUNT){
+    OS_Signal(&s);
+    SignalCount1++;
+  }
+}
+void Signal2(void){       // called every 1111us in background
+  if(SignalCount2<MAXCOUNT){
+    OS_Signal(&s);
+    SignalCount2++;
+  }
+}
+void Signal3(void){       // foreground
+  while(SignalCount3<SIGNAL3COUNT){
+    OS_Signal(&s);
+    SignalCount3++;
+  }
+  OS_Kill();
+}
+int Report6(void){
+  long signalled = SignalCount1+SignalCount2+SignalCount3;
+  long waited = WaitCount1+WaitCount2+WaitCount3;
+  long left = (s.value > 0) ? s.value : 0;
+
+  // A waiter may be between OS_Wait and its count, so allow one each
+  int ok = (SignalCount3 == SIGNAL3COUNT) && (signalled - waited - left >= 0) &&
+           (signalled - waited - left <= 3);
+  printf("testmain6 Signalled=%ld Waited=%ld Value=%d %s\n",
+         signalled, waited, s.value, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain6(void){
+  OS_Init();           // initialize, disable interrupts
+  SignalCount1 = 0;
+  SignalCount2 = 0;
+  SignalCount3 = 0;
+  WaitCount1 = 0;
+  WaitCount2 = 0;
+  WaitCount3 = 0;
+  OS_InitSemaphore(&s,0);	 // this is the test semaphore
+  OS_AddPeriodicThread(&Signal1,(799*TIME_1MS)/1000,0);   // 0.799 ms, higher priority
+  OS_AddPeriodicThread(&Signal2,(1111*TIME_1MS)/1000,1);  // 1.111 ms, lower priority
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&Thread6,128,6);    	// idle thread to keep from crashing
+  NumCreated += OS_AddThread(&Signal3,128,3); 	// signalling thread
+  NumCreated += OS_AddThread(&Wait1,128,2); 	// waiting thread
+  NumCreated += OS_AddThread(&Wait2,128,2); 	// waiting thread
+  NumCreated += OS_AddThread(&Wait3,128,2); 	// waiting thread
+  Host_RunFor(2000, &Report6);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Seventh TEST**********
+// FIFO objects, a periodic producer puts bursts with OS_Fifo_SendN and a
+// consumer drains them with OS_Fifo_RecvN, while another thread times
+// out on a FIFO that stays empty
+#define BURST 4
+FifoType DataFifo;
+unsigned long DataFifoBuffer[16];
+FifoType EmptyFifo;
+unsigned long EmptyFifoBuffer[4];
+unsigned long volatile Sent;        // entries put
+unsigned long volatile Received;    // entries taken
+unsigned long volatile Bursts;      // calls to OS_Fifo_RecvN
+unsigned long volatile OutOfOrder;  // entries not in the order sent
+unsigned long volatile Timeouts;    // OS_Fifo_RecvTimeout that ran out
+void BurstProducer(void){   // called every 4 ms in background
+  unsigned long data[BURST];
+  int i;
+  for(i = 0; i < BURST; i++){
+    data[i] = Sent + i;
+  }
+  Sent += OS_Fifo_SendN(&DataFifo, data, BURST);
+}
+void BurstConsumer(void){
+  unsigned long data[16];
+  unsigned long i, n;
+  for(;;){
+    n = OS_Fifo_RecvN(&DataFifo, data, 16);
+    for(i = 0; i < n; i++){
+      if(data[i] != Received){
+        OutOfOrder++;
+      }
+      Received++;
+    }
+    Bursts++;
+  }
+}
+void TimeoutThread(void){
+  unsigned long data;
+  for(;;){
+    if(OS_Fifo_RecvTimeout(&EmptyFifo, &data, 10) == TIMEOUT){
+      Timeouts++;
+    }
+  }
+}
+int volatile FifoInitFails;
+int Report7(void){
+  // 250 bursts in 1 s, each one taken whole, and 100 10 ms timeouts
+  int ok = (Sent > 200*BURST) && (Received + DataFifo.count == Sent) && (OutOfOrder == 0) &&
+           (Received >= BURST*Bursts - BURST) && (DataFifo.lost == 0) &&
+           (Timeouts >= 80) && (Timeouts <= 100) && FifoInitFails;
+  printf("testmain7 Sent=%lu Received=%lu Bursts=%lu OutOfOrder=%lu Lost=%lu Timeouts=%lu InitFails=%d %s\n",
+         Sent, Received, Bursts, OutOfOrder, DataFifo.lost, Timeouts, FifoInitFails, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain7(void){
+  OS_Init();           // initialize, disable interrupts
+  FifoInitFails = (OS_Fifo_Init(MAX_OS_FIFOSIZE+1) == FAIL);
+  OS_Fifo_Create(&DataFifo, DataFifoBuffer, 16);
+  OS_Fifo_Create(&EmptyFifo, EmptyFifoBuffer, 4);
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&BurstConsumer,128,1);
+  NumCreated += OS_AddThread(&TimeoutThread,128,2);
+  NumCreated += OS_AddThread(&Thread6,128,3);
+  OS_AddPeriodicThread(&BurstProducer,4*TIME_1MS,0);
+  Host_RunFor(1000, &Report7);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Eighth TEST**********
+// Message queues, a periodic thread fills 40 byte buffers taken from a
+// queue of free buffers and hands them to a thread that checks them and
+// gives them back
+#define NUM_MESSAGES 4
+typedef struct TestMessage{
+  unsigned long seq;
+  unsigned long words[10];
+}TestMessage;
+TestMessage Messages[NUM_MESSAGES];
+MsgQueueType FreeMessages;
+MsgQueueType FullMessages;
+void * FreeMessageSlots[NUM_MESSAGES];
+void * FullMessageSlots[NUM_MESSAGES];
+unsigned long volatile MessagesSent;
+unsigned long volatile MessagesReceived;
+unsigned long volatile MessagesBad;      // contents or order wrong
+unsigned long volatile NoFreeMessage;    // sends skipped, all buffers in use
+void MessageSender(void){   // called every 1 ms in background
+  void * msgPt;
+  TestMessage * message;
+  int i;
+  if(OS_MsgQueue_RecvTimeout(&FreeMessages, &msgPt, 0) == TIMEOUT){
+    NoFreeMessage++;
+    return;
+  }
+  message = (TestMessage *)msgPt;
+  message->seq = MessagesSent;
+  for(i = 0; i < 10; i++){
+    message->words[i] = MessagesSent + i;
+  }
+  OS_MsgQueue_Send(&FullMessages, message);
+  MessagesSent++;
+}
+void MessageReceiver(void){
+  TestMessage * message;
+  int i;
+  for(;;){
+    message = (TestMessage *)OS_MsgQueue_Recv(&FullMessages);
+    if(message->seq != MessagesReceived){
+      MessagesBad++;
+    }
+    for(i = 0; i < 10; i++){
+      if(message->words[i] != message->seq + i){
+        MessagesBad++;
+      }
+    }
+    MessagesReceived++;
+    OS_MsgQueue_Send(&FreeMessages, message);
+  }
+}
+int Report8(void){
+  // Every buffer is in a queue, except one the receiver may hold
+  unsigned long queued = FreeMessages.fifo.count + FullMessages.fifo.count;
+  int ok = (MessagesSent > 750) && (MessagesReceived + FullMessages.fifo.count + 1 >= MessagesSent) &&
+           (MessagesBad == 0) && (NoFreeMessage == 0) && (queued + 1 >= NUM_MESSAGES);
+  printf("testmain8 Sent=%lu Received=%lu Bad=%lu NoFree=%lu Queued=%lu %s\n",
+         MessagesSent, MessagesReceived, MessagesBad, NoFreeMessage, queued, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain8(void){
+  int i;
+  OS_Init();           // initialize, disable interrupts
+  OS_MsgQueue_Create(&FreeMessages, FreeMessageSlots, NUM_MESSAGES);
+  OS_MsgQueue_Create(&FullMessages, FullMessageSlots, NUM_MESSAGES);
+  for(i = 0; i < NUM_MESSAGES; i++){
+    OS_MsgQueue_Send(&FreeMessages, &Messages[i]);
+  }
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&MessageReceiver,128,1);
+  NumCreated += OS_AddThread(&Thread6,128,3);
+  OS_AddPeriodicThread(&MessageSender,TIME_1MS,0);
+  Host_RunFor(1000, &Report8);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Ninth TEST**********
+// Memory pools, a periodic thread takes message buffers out of a pool and
+// sends them to a thread that checks them and frees them, so every block
+// is allocated in an ISR and freed in a thread
+PoolType MessagePool;
+unsigned long MessagePoolStorage[POOL_WORDS(sizeof(TestMessage), NUM_MESSAGES)];
+unsigned long volatile EmptyFails;    // fails counted by the empty pool check
+void PoolSender(void){   // called every 1 ms in background
+  TestMessage * message = (TestMessage *)OS_Pool_Alloc(&MessagePool);
+  int i;
+  if(message == NULL){
+    NoFreeMessage++;
+    return;
+  }
+  message->seq = MessagesSent;
+  for(i = 0; i < 10; i++){
+    message->words[i] = MessagesSent + i;
+  }
+  if(OS_MsgQueue_Send(&FullMessages, message) == FAIL){
+    OS_Pool_Free(&MessagePool, message);
+    return;
+  }
+  MessagesSent++;
+}
+void PoolReceiver(void){
+  TestMessage * message;
+  int i;
+  for(;;){
+    message = (TestMessage *)OS_MsgQueue_Recv(&FullMessages);
+    if(message->seq != MessagesReceived){
+      MessagesBad++;
+    }
+    for(i = 0; i < 10; i++){
+      if(message->words[i] != message->seq + i){
+        MessagesBad++;
+      }
+    }
+    MessagesReceived++;
+    OS_Pool_Free(&MessagePool, message);
+  }
+}
+int Report9(void){
+  // The check before launch used every block, then each message is freed
+  // before the next one is sent
+  int ok = (MessagesSent > 750) && (MessagesReceived + FullMessages.fifo.count + 1 >= MessagesSent) &&
+           (MessagesBad == 0) && (NoFreeMessage == 0) && (EmptyFails == 1) &&
+           (MessagePool.maxUsed == NUM_MESSAGES) && (MessagePool.used <= 1) &&
+           (MessagePool.allocs == MessagesSent + NUM_MESSAGES) && (Pools == &MessagePool);
+  printf("testmain9 Sent=%lu Received=%lu Bad=%lu NoFree=%lu Used=%lu MaxUsed=%lu Fails=%lu %s\n",
+         MessagesSent, MessagesReceived, MessagesBad, NoFreeMessage, MessagePool.used,
+         MessagePool.maxUsed, MessagePool.fails, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain9(void){
+  void * blocks[NUM_MESSAGES];
+  int i;
+  OS_Init();           // initialize, disable interrupts
+  OS_Pool_Create(&MessagePool, "Messages", MessagePoolStorage, sizeof(TestMessage), NUM_MESSAGES);
+  OS_MsgQueue_Create(&FullMessages, FullMessageSlots, NUM_MESSAGES);
+  // Empty the pool, one more alloc fails, then give the blocks back
+  for(i = 0; i < NUM_MESSAGES; i++){
+    blocks[i] = OS_Pool_Alloc(&MessagePool);
+  }
+  if(OS_Pool_Alloc(&MessagePool) == NULL){
+    EmptyFails = MessagePool.fails;
+  }
+  for(i = 0; i < NUM_MESSAGES; i++){
+    OS_Pool_Free(&MessagePool, blocks[i]);
+  }
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&PoolReceiver,128,1);
+  NumCreated += OS_AddThread(&Thread6,128,3);
+  OS_AddPeriodicThread(&PoolSender,TIME_1MS,0);
+  Host_RunFor(1000, &Report9);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Tenth TEST**********
+// Deferred work, a periodic thread defers one work item per release and
+// every 100th release defers more than the queue holds.  A busy thread at
+// the highest user priority must not hold the work up, and no user thread
+// may be added at DEFER_PRIORITY
+#define DEFER_BURST (DEFER_QUEUE_SIZE+4)
+unsigned long volatile Releases;
+unsigned long volatile WorkDone;
+unsigned long volatile WorkBad;        // out of order, or not in the defer thread
+int volatile DeferAddFails;
+void DeferredWork(unsigned long arg){
+  if((arg != WorkDone) || (CurrentThread->priority != DEFER_PRIORITY)){
+    WorkBad++;
+  }
+  WorkDone++;
+}
+unsigned long volatile WorkPosted;     // work items OS_Defer took
+void DeferProducer(void){   // called every 1 ms in background
+  int i, n = ((Releases%100) == 50) ? DEFER_BURST : 1;
+  Releases++;
+  for(i = 0; i < n; i++){
+    if(OS_Defer(&DeferredWork, WorkPosted) == SUCCESS){
+      WorkPosted++;
+    }
+  }
+}
+int Report10(void){
+  // Each burst loses the 4 items that do not fit
+  unsigned long bursts = (Releases + 49)/100;
+  int ok = (Releases > 900) && (WorkBad == 0) && (WorkDone + 1 >= WorkPosted) &&
+           (DeferQueue.lost == 4*bursts) && (DeferQueue.max == DEFER_QUEUE_SIZE) && (Count1 > 0) &&
+           DeferAddFails;
+  printf("testmain10 Releases=%lu Posted=%lu Done=%lu Bad=%lu Lost=%lu Max=%lu AddFails=%d %s\n",
+         Releases, WorkPosted, WorkDone, WorkBad, DeferQueue.lost, DeferQueue.max, DeferAddFails,
+         PASS_FAIL(ok));
+  return !ok;
+}
+int testmain10(void){
+  OS_Init();           // initialize, disable interrupts
+  NumCreated = 0 ;
+  DeferAddFails = (OS_AddThread(&Thread6,128,DEFER_PRIORITY) == FAIL);
+  NumCreated += OS_AddThread(&Thread6,128,OS_USER_PRIORITY);
+  OS_AddPeriodicThread(&DeferProducer,TIME_1MS,0);
+  Host_RunFor(1000, &Report10);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Eleventh TEST**********
+// Event flags, a periodic thread sets flag 0, 1, 2 and 3 in turn.  One
+// thread waits for any of flags 0 and 1, one for all of flags 2 and 3,
+// and one for a flag that is never set until its timeout
+FlagsType TestFlags;
+unsigned long volatile FlagSets;
+unsigned long volatile AnyWakes;
+unsigned long volatile AllWakes;
+unsigned long volatile FlagTimeouts;
+unsigned long volatile FlagsBad;       // woken with the wrong flags
+void FlagSetter(void){   // called every 1 ms in background
+  OS_SetFlags(&TestFlags, 1ul << (FlagSets%4));
+  FlagSets++;
+}
+void AnyWaiter(void){
+  unsigned long flags;
+  for(;;){
+    flags = OS_WaitFlags(&TestFlags, 0x3, FLAGS_ANY|FLAGS_CLEAR);
+    if((flags == 0) || (flags & ~0x3ul)){
+      FlagsBad++;
+    }
+    AnyWakes++;
+  }
+}
+void AllWaiter(void){
+  for(;;){
+    if(OS_WaitFlags(&TestFlags, 0xC, FLAGS_ALL|FLAGS_CLEAR) != 0xC){
+      FlagsBad++;
+    }
+    AllWakes++;
+  }
+}
+void TimeoutWaiter(void){
+  for(;;){
+    if(OS_WaitFlagsTimeout(&TestFlags, 0x80000000, FLAGS_ANY, 5) == 0){
+      FlagTimeouts++;
+    }else{
+      FlagsBad++;
+    }
+  }
+}
+int Report11(void){
+  // Each flag is set every 4 ms and the waiters run above the busy thread
+  int ok = (FlagSets > 900) && (FlagsBad == 0) && (AnyWakes + 2 >= FlagSets/2) &&
+           (AnyWakes <= FlagSets/2 + 1) && (AllWakes + 1 >= FlagSets/4) &&
+           (AllWakes <= FlagSets/4) && (FlagTimeouts > 150) && (Count1 > 0);
+  printf("testmain11 Sets=%lu Any=%lu All=%lu Timeouts=%lu Bad=%lu %s\n",
+         FlagSets, AnyWakes, AllWakes, FlagTimeouts, FlagsBad, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain11(void){
+  OS_Init();           // initialize, disable interrupts
+  OS_InitFlags(&TestFlags, 0);
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&AnyWaiter,128,1);
+  NumCreated += OS_AddThread(&AllWaiter,128,1);
+  NumCreated += OS_AddThread(&TimeoutWaiter,128,2);
+  NumCreated += OS_AddThread(&Thread6,128,3);
+  OS_AddPeriodicThread(&FlagSetter,TIME_1MS,0);
+  Host_RunFor(1000, &Report11);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Twelfth TEST**********
+// CPU load, a thread busy for 3 ms of every 10 ms and nothing else to
+// run, so the idle thread has the rest
+extern TCB * IdleThread;
+extern unsigned long CpuLoad1s;
+extern unsigned long CpuLoad10s;
+unsigned long volatile BusyPeriods;
+void BusyThread(void){
+  unsigned long start;
+  for(;;){
+    start = OS_Time();
+    while(OS_TimeDifference(OS_Time(), start) < 3*TIME_1MS){
+    }
+    BusyPeriods++;
+    OS_Sleep(7);
+  }
+}
+int Report12(void){
+  // The sleep ends on a tick, so a period is 10 to 11 ms
+  int ok = (BusyPeriods > 200) && (CpuLoad1s > 250) && (CpuLoad1s < 400) &&
+           (CpuLoad10s > 250) && (CpuLoad10s < 400) && (IdleThread->switches > 200);
+  printf("testmain12 Periods=%lu Load1s=%lu.%lu%% Load10s=%lu.%lu%% IdleSwitches=%lu %s\n",
+         BusyPeriods, CpuLoad1s/10, CpuLoad1s%10, CpuLoad10s/10, CpuLoad10s%10,
+         IdleThread->switches, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain12(void){
+  OS_Init();           // initialize, disable interrupts
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&BusyThread,128,1);
+  Host_RunFor(2500, &Report12);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Thirteenth TEST**********
+// OS_SleepUntil, one loop runs 1 ms of every 5 ms and must wake on each
+// release, the other runs every 4 ms but every 8th pass takes 10 ms, so
+// it overruns two releases and must keep its phase
+unsigned long SteadyStart;
+unsigned long volatile SteadyReleases;
+unsigned long volatile SteadyLate;      // woken after the release
+unsigned long volatile SteadyOverruns;
+unsigned long volatile BurstPasses;
+unsigned long volatile BurstOverruns;
+unsigned long volatile BurstPhase;      // releases off the 4 ms grid
+void Busy(unsigned long ms){
+  unsigned long start = OS_Time();
+  while(OS_TimeDifference(OS_Time(), start) < ms*TIME_1MS){
+  }
+}
+void SteadyLoop(void){
+  unsigned long lastWake = OS_MsTime();
+  SteadyStart = lastWake;
+  for(;;){
+    Busy(1);
+    OS_SleepUntil(&lastWake, 5);
+    if(OS_MsTime() != lastWake){
+      SteadyLate++;
+    }
+    SteadyReleases++;
+    SteadyOverruns = CurrentThread->overruns;
+  }
+}
+void BurstLoop(void){
+  unsigned long lastWake = OS_MsTime();
+  unsigned long start = lastWake;
+  for(;;){
+    BurstPasses++;
+    Busy(((BurstPasses%8) == 0) ? 10 : 1);
+    OS_SleepUntil(&lastWake, 4);
+    if(((lastWake - start)%4) != 0){
+      BurstPhase++;
+    }
+    BurstOverruns = CurrentThread->overruns;
+  }
+}
+int Report13(void){
+  unsigned long releases = (OS_MsTime() - SteadyStart)/5;
+  int ok = (SteadyReleases + 1 >= releases) && (SteadyReleases <= releases) &&
+           (SteadyLate == 0) && (SteadyOverruns == 0) && (BurstPasses > 100) &&
+           (BurstOverruns + 2 >= 2*(BurstPasses/8)) && (BurstOverruns <= 2*(BurstPasses/8)) &&
+           (BurstPhase == 0);
+  printf("testmain13 Releases=%lu/%lu Late=%lu Overruns=%lu BurstPasses=%lu BurstOverruns=%lu Phase=%lu %s\n",
+         SteadyReleases, releases, SteadyLate, SteadyOverruns, BurstPasses, BurstOverruns,
+         BurstPhase, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain13(void){
+  OS_Init();           // initialize, disable interrupts
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&SteadyLoop,128,1);
+  NumCreated += OS_AddThread(&BurstLoop,128,2);
+  Host_RunFor(1000, &Report13);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Fourteenth TEST**********
+// Timeouts, a binary semaphore signaled every 20 ms is waited for 5 ms at
+// a time, and a mutex that is never unlocked, a mailbox that is never
+// sent to and an empty FIFO must all time out.  The mutex owner is
+// blocked on a second mutex, and after each timeout both owners must be
+// back at the priority they had before the wait
+Sema4Type BinarySema;
+MutexType HeldMutex;
+MutexType ChainMutex;
+TCB * HolderThread;
+TCB * ChainThread;
+FifoType NoDataFifo;
+unsigned long NoDataBuffer[4];
+unsigned long volatile BSignals;
+unsigned long volatile BGot;
+unsigned long volatile BTimeouts;
+unsigned long volatile LockTimeouts;
+unsigned long volatile RecvTimeouts;
+unsigned long volatile TimeoutsBad;
+void BinarySignaller(void){   // called every 20 ms in background
+  BSignals++;
+  OS_bSignal(&BinarySema);
+}
+void BinaryWaiter(void){
+  int status;
+  for(;;){
+    status = OS_bWaitTimeout(&BinarySema, 5);
+    if(status == SUCCESS){
+      BGot++;
+    }else if(status == TIMEOUT){
+      BTimeouts++;
+    }else{
+      TimeoutsBad++;
+    }
+  }
+}
+void MutexHolder(void){
+  HolderThread = CurrentThread;
+  OS_MutexLock(&HeldMutex);
+  for(;;){
+    Count1++;
+  }
+}
+void ChainHolder(void){
+  ChainThread = CurrentThread;
+  OS_Sleep(1);         // let MutexHolder take HeldMutex
+  OS_MutexLock(&ChainMutex);
+  OS_MutexLock(&HeldMutex);
+  TimeoutsBad++;       // never gets HeldMutex
+}
+void LockWaiter(void){
+  unsigned long data[4];
+  OS_Sleep(3);         // let ChainHolder block on HeldMutex
+  for(;;){
+    if((OS_MutexLockTimeout(&ChainMutex, 3) == TIMEOUT) && (CurrentThread->MutexBlockPt == NULL) &&
+       (ChainThread->priority == ChainThread->basePriority) &&
+       (HolderThread->priority == ChainThread->basePriority)){
+      LockTimeouts++;
+    }else{
+      TimeoutsBad++;
+    }
+    if((OS_MailBox_RecvTimeout(&data[0], 2) == TIMEOUT) &&
+       (OS_Fifo_RecvNTimeout(&NoDataFifo, data, 4, 2) == 0)){
+      RecvTimeouts++;
+    }else{
+      TimeoutsBad++;
+    }
+  }
+}
+int Report14(void){
+  // A LockWaiter pass waits 3+2+2 ms, and the owner it raised to its
+  // priority may finish its time slice before the waiter runs again
+  int ok = (BSignals > 45) && (BGot + 1 >= BSignals) && (BGot <= BSignals) &&
+           (BTimeouts > 100) && (LockTimeouts > 60) && (RecvTimeouts + 1 >= LockTimeouts) &&
+           (TimeoutsBad == 0) && (Count1 > 0);
+  printf("testmain14 Signals=%lu Got=%lu Timeouts=%lu LockTimeouts=%lu RecvTimeouts=%lu Bad=%lu %s\n",
+         BSignals, BGot, BTimeouts, LockTimeouts, RecvTimeouts, TimeoutsBad, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain14(void){
+  OS_Init();           // initialize, disable interrupts
+  OS_InitSemaphore(&BinarySema, 0);
+  OS_InitMutex(&HeldMutex);
+  OS_InitMutex(&ChainMutex);
+  OS_MailBox_Init();
+  OS_Fifo_Create(&NoDataFifo, NoDataBuffer, 4);
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&BinaryWaiter,128,1);
+  NumCreated += OS_AddThread(&LockWaiter,128,2);
+  NumCreated += OS_AddThread(&ChainHolder,128,3);
+  NumCreated += OS_AddThread(&MutexHolder,128,4);
+  OS_AddPeriodicThread(&BinarySignaller,20*TIME_1MS,0);
+  Host_RunFor(1000, &Report14);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Fifteenth TEST**********
+// Worker pool, a periodic thread submits one job per release and every
+// 100th release submits more than the queue holds.  Each job sleeps, so
+// the workers have to run several jobs at once, and a job must never run
+// in a thread other than the three workers
+#define TEST_WORKERS 3
+#define WORKER_PRIORITY 2
+#define JOB_BURST (JOB_QUEUE_SIZE+4)
+unsigned long volatile JobsPosted;
+unsigned long volatile JobsBad;        // not run by a worker
+unsigned char WorkerIds[MAX_WORKERS];
+unsigned long NumWorkerIds;            // workers seen running a job
+int volatile InitFails;
+void SleepyJob(unsigned long arg){
+  unsigned long i;
+  long sr = SRSave();
+  for(i = 0; (i < NumWorkerIds) && (WorkerIds[i] != CurrentThread->id); i++){
+  }
+  if(i == NumWorkerIds){
+    if(NumWorkerIds < TEST_WORKERS){
+      WorkerIds[NumWorkerIds++] = CurrentThread->id;
+    }else{
+      JobsBad++;
+    }
+  }
+  if(CurrentThread->priority != WORKER_PRIORITY){
+    JobsBad++;
+  }
+  SRRestore(sr);
+  OS_Sleep(2);
+}
+void JobProducer(void){   // called every 1 ms in background
+  int i, n = ((Releases%100) == 50) ? JOB_BURST : 1;
+  Releases++;
+  for(i = 0; i < n; i++){
+    if(OS_Submit(&SleepyJob, Releases) == SUCCESS){
+      JobsPosted++;
+    }
+  }
+}
+int Report15(void){
+  // Each burst fills the queue and loses at least the 4 jobs that do not fit
+  unsigned long bursts = (Releases + 49)/100;
+  int ok = (Releases > 900) && (JobsBad == 0) && (InitFails == 1) &&
+           (NumWorkers == TEST_WORKERS) && (NumWorkerIds == TEST_WORKERS) &&
+           (WorkQueue.run + JOB_QUEUE_SIZE + TEST_WORKERS >= JobsPosted) &&
+           (WorkQueue.run <= JobsPosted) &&
+           (WorkQueue.lost >= 4*bursts) && (WorkQueue.max == JOB_QUEUE_SIZE) &&
+           (WorkQueue.maxBusy == TEST_WORKERS) && (Count1 > 0);
+  printf("testmain15 Releases=%lu Posted=%lu Run=%lu Lost=%lu Max=%lu Busy=%lu Bad=%lu %s\n",
+         Releases, JobsPosted, WorkQueue.run, WorkQueue.lost, WorkQueue.max, WorkQueue.maxBusy, JobsBad, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain15(void){
+  OS_Init();           // initialize, disable interrupts
+  InitFails = (OS_InitWorkers(MAX_WORKERS+1, WORKER_PRIORITY) == FAIL);
+  OS_InitWorkers(TEST_WORKERS, WORKER_PRIORITY);
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&Thread6,128,3);
+  OS_AddPeriodicThread(&JobProducer,TIME_1MS,0);
+  Host_RunFor(1000, &Report15);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Sixteenth TEST**********
+// Periodic admission, a 50 ms task that runs for 10 ms is added with a
+// 15 ms budget.  A 100 ms task with a 75 ms budget would need more than
+// the processor and must be rejected, one with a 25 ms budget fits.  The
+// periods are long so a PC that takes the CPU away for a few ms does not
+// make the set unschedulable.  Each task times itself, and the WCET the
+// kernel measures must be no more than that plus the call.
+unsigned long volatile ShortRuns;
+unsigned long volatile LongRuns;
+unsigned long volatile ShortMax;
+unsigned long volatile LongMax;
+void Spin(unsigned long cycles){
+  unsigned long start = OS_Time();
+  while(OS_TimeDifference(OS_Time(), start) < (long)cycles){
+  }
+}
+void ShortTask(void){   // called every 1 ms in background
+  ShortRuns++;
+  Spin(TIME_1MS/5);
+}
+void LongTask(void){    // never released in test 17
+  LongRuns++;
+  Spin(TIME_1MS/10);
+}
+void BudgetShortTask(void){   // called every 50 ms in background
+  unsigned long start = OS_Time();
+  ShortRuns++;
+  Spin(10*TIME_1MS);
+  if(OS_Time() - start > ShortMax){
+    ShortMax = OS_Time() - start;
+  }
+}
+void BudgetLongTask(void){    // called every 100 ms in background
+  unsigned long start = OS_Time();
+  LongRuns++;
+  Spin(5*TIME_1MS);
+  if(OS_Time() - start > LongMax){
+    LongMax = OS_Time() - start;
+  }
+}
+int volatile Rejected;
+int volatile Admitted;
+int Report16(void){
+  unsigned long load, busy, unknown;
+  unsigned long shortWcet = PeriodicTasks[0].wcet;
+  unsigned long longWcet = PeriodicTasks[1].wcet;
+  int ok, schedulable;
+  schedulable = OS_PeriodicSchedulable(&load, &busy, &unknown);
+  // The costs are at least the budgets, 30% + 25%, and the runs measured
+  // must fit in the shortest period
+  ok = (ShortRuns > 15) && (LongRuns > 7) && Rejected && Admitted &&
+       (PeriodicUnschedulable == 1) && (NumPeriodic == 2) &&
+       (shortWcet >= 10*TIME_1MS) && (shortWcet <= ShortMax + TIME_1MS/10) &&
+       (longWcet >= 5*TIME_1MS) && (longWcet <= LongMax + TIME_1MS/10) &&
+       (load >= 550) && (busy >= 40*TIME_1MS) && (busy <= 50*TIME_1MS) &&
+       schedulable && (unknown == 0) && (Count1 > 0);
+  printf("testmain16 ShortRuns=%lu LongRuns=%lu WCET=%luus,%luus Self=%luus,%luus Load=%lu.%lu%% Busy=%luus Unschedulable=%lu %s\n",
+         ShortRuns, LongRuns, shortWcet/(1000/CLOCK_PERIOD), longWcet/(1000/CLOCK_PERIOD),
+         ShortMax/(1000/CLOCK_PERIOD), LongMax/(1000/CLOCK_PERIOD),
+         load/10, load%10, busy/(1000/CLOCK_PERIOD), PeriodicUnschedulable, PASS_FAIL(ok));
+  return !ok;
+}
+int testmain16(void){
+  OS_Init();           // initialize, disable interrupts
+  ShortRuns = 0;
+  LongRuns = 0;
+  ShortMax = 0;
+  LongMax = 0;
+  OS_AddPeriodicThreadBudget(&BudgetShortTask,50*TIME_1MS,0,15*TIME_1MS);
+  Rejected = (OS_AddPeriodicThreadBudget(&BudgetLongTask,100*TIME_1MS,1,75*TIME_1MS) == FAIL);
+  Admitted = (OS_AddPeriodicThreadBudget(&BudgetLongTask,100*TIME_1MS,1,25*TIME_1MS) != FAIL);
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&Thread6,128,3);
+  Host_RunFor(1000, &Report16);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+//*******************Seventeenth TEST**********
+// Jitter statistics, a 1 ms task and a 2 ms task that overruns by two
+// releases every 100th run, which also makes the 1 ms task miss a few.
+// A third task is never released, its histogram is filled by hand to
+// check the percentiles
+unsigned long volatile LateRuns;
+void OverrunTask(void){   // called every 2 ms in background
+  LateRuns++;
+  if((LateRuns%100) == 50){
+    Spin(5*TIME_1MS);
+  }
+}
+int Report17(void){
+  JitterType * onTimePt = &PeriodicTasks[0].jitter;
+  JitterType * latePt = &PeriodicTasks[1].jitter;
+  long p50 = OS_JitterPercentile(1, 500);
+  long p99 = OS_JitterPercentile(1, 990);
+  long p999 = OS_JitterPercentile(1, 999);
+  // Each overrun skips at least two releases, the next release is not
+  // measured
+  unsigned long overruns = (LateRuns + 50)/100;
+  int ok = (ShortRuns > 900) && (onTimePt->count + 1 + onTimePt->misses >= ShortRuns) &&
+           (onTimePt->misses >= 3*overruns) &&
+           (onTimePt->min <= p50) && (p50 <= p99) && (p99 <= p999) && (p999 <= onTimePt->max) &&
+           (LateRuns > 300) && (latePt->misses >= 2*overruns) &&
+           (latePt->count + 1 + latePt->misses >= LateRuns) &&
+           (OS_JitterPercentile(3, 500) == 63) && (OS_JitterPercentile(3, 990) == 127) &&
+           (OS_JitterPercentile(3, 999) == 319) && (OS_JitterPercentile(3, 1000) == 5000) &&
+           (OS_JitterPercentile(4, 500) == 0) && (Count1 > 0);
+  printf("testmain17 Count=%lu p50=%ld p99=%ld p99.9=%ld Max=%ld Misses=%lu LateRuns=%lu LateMisses=%lu %s\n",
+         onTimePt->count, p50, p99, p999, onTimePt->max, onTimePt->misses, LateRuns, latePt->misses,
+         PASS_FAIL(ok));
+  return !ok;
+}
+int testmain17(void){
+  JitterType * filledPt;
+  OS_Init();           // initialize, disable interrupts
+  ShortRuns = 0;
+  LateRuns = 0;
+  OS_AddPeriodicThread(&ShortTask,TIME_1MS,0);
+  OS_AddPeriodicThread(&OverrunTask,2*TIME_1MS,1);
+  OS_AddPeriodicThread(&LongTask,0x40000000,2);
+  // 500 releases 0 to 63 cycles late, 490 64 to 127, 9 256 to 319, 1 5000
+  filledPt = &PeriodicTasks[2].jitter;
+  filledPt->histogram[JITTER_BINS/2] = 500;
+  filledPt->histogram[JITTER_BINS/2+1] = 490;
+  filledPt->histogram[JITTER_BINS/2+4] = 9;
+  filledPt->histogram[JITTER_BINS-1] = 1;
+  filledPt->count = 1000;
+  filledPt->min = 0;
+  filledPt->max = 5000;
+  NumCreated = 0 ;
+  NumCreated += OS_AddThread(&Thread6,128,3);
+  Host_RunFor(1000, &Report17);
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;             // this never executes
+}
+
+int (* const TestMains[])(void) = {
+  testmain1, testmain2, testmain3, testmain4, testmain5, testmain6, testmain7,
+  testmain8, testmain9, testmain10, testmain11, testmain12, testmain13, testmain14,
+  testmain15, testmain16, testmain17
+};
+#define NUM_TESTMAINS (sizeof(TestMains)/sizeof(TestMains[0]))
+
+int main(int argc, char ** argv){
+  int test = (argc == 2) ? atoi(argv[1]) : 0;
+
+  if((test < 1) || (test > (int)NUM_TESTMAINS)){
+    fprintf(stderr, "usage: %s 1..%d\n", argv[0], (int)NUM_TESTMAINS);
+    return 2;
+  }
+  return TestMains[test-1]();
+}
@@ -0,0 +1,156 @@
+//*****************************************************************************
+//
+// Filename: trace2json.c
+// Description: Host decoder for the kernel trace in drivers/OS_trace.c.
+// Reads a capture of the UART stream or the trace.bin file and writes a
+// Chrome trace (load it in chrome://tracing or ui.perfetto.dev).  Threads,
+// periodic threads and ISR classes each get their own row.
+//
+// Every record is TRACE_SYNC followed by 8 bytes: the 32-bit OS_Time count,
+// event, id and a 16-bit argument, little endian.  Bytes dropped by the
+// UART are skipped by looking for the next TRACE_SYNC.  OS_Time is the low
+// 32 bits of the timebase, so time is unwrapped from record to record.
+//
+// This file runs on the development PC, not on the board.  Build and run
+// from boards/ek-lm3s8962:
+//
+//   gcc -O2 -I. -o trace2json tools/trace2json.c
+//   ./trace2json capture.bin > trace.json
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include "drivers/OS.h"
+#include "drivers/OS_trace.h"
+
+#define RECORD_BYTES 8
+#define CYCLES_PER_US (1000/CLOCK_PERIOD)
+
+static const char * const IsrNames[NUM_ISR_CLASSES] = {"Periodic", "SysTick", "UART", "CAN"};
+
+FILE * Out;
+int FirstEvent = 1;
+
+//***********************************************************************
+//
+// Emit writes one Chrome trace event.  pid 1 is the threads, pid 2 the
+// periodic threads and pid 3 the ISRs.
+//
+//***********************************************************************
+static void
+Emit(const char * name, const char * phase, double us, int pid, int tid, const char * args)
+{
+  fprintf(Out, "%s\n{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.2f,\"pid\":%d,\"tid\":%d%s%s}",
+          FirstEvent ? "" : ",", name, phase, us, pid, tid, args ? "," : "", args ? args : "");
+  FirstEvent = 0;
+}
+
+int
+main(int argc, char ** argv)
+{
+  FILE * in;
+  int c, i;
+  unsigned char b[RECORD_BYTES];
+  unsigned long raw, lastRaw = 0;
+  unsigned event, id, arg;
+  long long cycles = 0;         // unwrapped time since the first record
+  int haveTime = 0;
+  int running = -1;             // thread that is running, -1 until the first switch
+  double runningSince = 0;
+  double us;
+  char name[32];
+  char args[64];
+  unsigned long records = 0, bad = 0, lost = 0;
+
+  if(argc != 2)
+  {
+    fprintf(stderr, "usage: %s capture.bin > trace.json\n", argv[0]);
+    return 1;
+  }
+  in = fopen(argv[1], "rb");
+  if(in == NULL)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  Out = stdout;
+  fprintf(Out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+  while((c = fgetc(in)) != EOF)
+  {
+    if(c != TRACE_SYNC)
+    {
+      continue;
+    }
+    for(i = 0; i < RECORD_BYTES; i++)
+    {
+      if((c = fgetc(in)) == EOF)
+      {
+        break;
+      }
+      b[i] = (unsigned char)c;
+    }
+    if(i < RECORD_BYTES)
+    {
+      break;
+    }
+    raw = b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned long)b[3] << 24);
+    event = b[4];
+    id = b[5];
+    arg = b[6] | (b[7] << 8);
+    if((event == TRACE_NONE) || (event > TRACE_LOST))
+    {
+      bad++;        // lost sync, look for the next TRACE_SYNC
+      continue;
+    }
+
+    // Records a little out of order come out negative
+    if(haveTime)
+    {
+      cycles += (int)(unsigned int)(raw - lastRaw);
+    }
+    lastRaw = raw;
+    haveTime = 1;
+    us = (double)cycles/CYCLES_PER_US;
+    records++;
+
+    switch(event)
+    {
+      case TRACE_SWITCH:
+        if(running >= 0)
+        {
+          sprintf(name, "Thread %d", running);
+          sprintf(args, "\"dur\":%.2f", us - runningSince);
+          Emit(name, "X", runningSince, 1, running, args);
+        }
+        running = arg;
+        runningSince = us;
+        break;
+      case TRACE_PERIODIC_START:
+      case TRACE_PERIODIC_END:
+        sprintf(name, "Periodic %u", id);
+        Emit(name, (event == TRACE_PERIODIC_START) ? "B" : "E", us, 2, id, NULL);
+        break;
+      case TRACE_SEM_BLOCK:
+      case TRACE_SEM_WAKE:
+        sprintf(args, "\"s\":\"t\",\"args\":{\"sema\":\"0x%04x\"}", arg);
+        Emit((event == TRACE_SEM_BLOCK) ? "Block" : "Wake", "i", us, 1, id, args);
+        break;
+      case TRACE_ISR_ENTER:
+      case TRACE_ISR_EXIT:
+        Emit((id < NUM_ISR_CLASSES) ? IsrNames[id] : "ISR",
+             (event == TRACE_ISR_ENTER) ? "B" : "E", us, 3, id, NULL);
+        break;
+      case TRACE_LOST:
+        lost += arg;
+        sprintf(args, "\"s\":\"g\",\"args\":{\"records\":%u}", arg);
+        Emit("Lost", "i", us, 1, 0, args);
+        break;
+    }
+  }
+
+  fprintf(Out, "\n]}\n");
+  fclose(in);
+  fprintf(stderr, "%lu records, %lu lost on the board, %lu bad\n", records, lost, bad);
+  return 0;
+}
@@ -19,6 +19,8 @@
 #include "drivers/rit128x96x4.h"
 #include "drivers/OS.h"
 #include "drivers/OSuart.h"
+#include "drivers/OS_defer.h"
+#include "drivers/OS_worker.h"
 #include "string.h"
 #include "ctype.h"
 
@@ -102,10 +104,9 @@ void DAS(void)
 
 //------------------Task 2--------------------------------
 // background thread executes with select button
-// one foreground task created with button push
-// foreground treads run for 2 sec and die
+// one job run by a worker thread per button push
 // ***********ButtonWork*************
-void ButtonWork(void){
+void ButtonWork(unsigned long arg){
 unsigned long i;
 unsigned long myId = OS_Id(); 
   oLED_Message(1,0,"NumCreated =",NumCreated); 
@@ -117,15 +118,14 @@ unsigned long myId = OS_Id();
   oLED_Message(1,1,"PIDWork    =",PIDWork);
   oLED_Message(1,2,"DataLost   =",DataLost);
   oLED_Message(1,3,"Jitter(us) =",MaxJitter-MinJitter);
-  OS_Kill();  // done
-} 
+}
 
 //************ButtonPush*************
 // Called when Select Button pushed
-// Adds another foreground task
+// Hands ButtonWork to the worker pool
 // background threads execute once and return
 void ButtonPush(void){
-  if(OS_AddThread(&ButtonWork,100,4)){
+  if(OS_Submit(&ButtonWork,0)){
     NumCreated++; 
   }
 }
@@ -169,7 +169,7 @@ unsigned long data,DCcomponent; // 10-bit raw ADC sample, 0 to 1023
 unsigned long t;  // time in ms
 unsigned long myId = OS_Id();
   ADC_Collect(0, 1000, &Producer); // start ADC sampling, channel 0, 1000 Hz
-  NumCreated += OS_AddThread(&Display,128,0); 
+  NumCreated += OS_AddThread(&Display,128,1); 
   while(NumSamples < RUNLENGTH) {
     for(t = 0; t < 64; t++){   // collect 64 ADC samples
       OS_Fifo_Get(&data);    // get from producer 
@@ -500,15 +500,16 @@ int main(void){
   OS_Fifo_Init(32);    // ***note*** 4 is not big enough*****
 
 //*******attach background tasks***********
+  OS_InitWorkers(1,5);   // thread that runs the button jobs
   OS_AddButtonTask(&ButtonPush,2);
   
   OS_AddPeriodicThread(&DAS,PERIOD,0); // 2 kHz real time sampling
 
   NumCreated = 0 ;
 // create initial foreground threads
-  NumCreated += OS_AddThread(&Interpreter,128,2); 
-  NumCreated += OS_AddThread(&Consumer,128,1); 
-  NumCreated += OS_AddThread(&PID,128,3);
+  NumCreated += OS_AddThread(&Interpreter,INTERPRETER_STACK_SIZE,3); 
+  NumCreated += OS_AddThread(&Consumer,128,2); 
+  NumCreated += OS_AddThread(&PID,128,4);
   OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
   return 0;             // this never executes
 }
@@ -24,6 +24,9 @@
 #include "string.h"
 #include "drivers/OS.h"
 #include "drivers/OSuart.h"
+#include "drivers/OS_defer.h"
+#include "drivers/OS_worker.h"
+#include "drivers/OS_periodic.h"
 #include "lm3s8962.h"
 #include "drivers/OSuart.h"
 
@@ -33,11 +36,6 @@ unsigned long FilterWork;   // number of digital filter calculations finished
 unsigned long NumSamples;   // incremented every sample
 unsigned long DataLost;     // data sent by Producer, but not received by Consumer
 
-extern unsigned long JitterHistogramA[];
-extern unsigned long JitterHistogramB[];
-extern long MaxJitterA;
-extern long MinJitterA;
-
 Sema4Type MailBoxFull;
 Sema4Type MailBoxEmpty;
 
@@ -87,10 +85,9 @@ unsigned short input;
 
 //------------------Task 2--------------------------------
 // background thread executes with select button
-// one foreground task created with button push
-// foreground treads run for 2 sec and die
+// one job run by a worker thread per button push
 // ***********ButtonWork*************
-void ButtonWork(void){
+void ButtonWork(unsigned long arg){
 unsigned long i;
 unsigned long myId = OS_Id(); 
   oLED_Message(1,0,"NumCreated =",NumCreated); 
@@ -101,25 +98,24 @@ unsigned long myId = OS_Id();
 // }
   oLED_Message(1,1,"PIDWork    =",PIDWork);
   oLED_Message(1,2,"DataLost   =",DataLost);
-  oLED_Message(1,3,"0.1u Jitter=",MaxJitterA-MinJitterA);
-  OS_Kill();  // done
-} 
+  oLED_Message(1,3,"Jitter p999=",OS_JitterPercentile(1,999));
+}
 
 //************ButtonPush*************
 // Called when Select Button pushed
-// Adds another foreground task
+// Hands ButtonWork to the worker pool
 // background threads execute once and return
 void ButtonPush(void){
-  if(OS_AddThread(&ButtonWork,100,1)){
+  if(OS_Submit(&ButtonWork,0)){
     NumCreated++; 
   }
 }
 //************DownPush*************
 // Called when Down Button pushed
-// Adds another foreground task
+// Hands ButtonWork to the worker pool
 // background threads execute once and return
 void DownPush(void){
-  if(OS_AddThread(&ButtonWork,100,1)){
+  if(OS_Submit(&ButtonWork,1)){
     NumCreated++; 
   }
 }
@@ -163,7 +159,7 @@ unsigned long data,DCcomponent; // 10-bit raw ADC sample, 0 to 1023
 unsigned long t;  // time in ms
 unsigned long myId = OS_Id(); 
   ADC_Collect(0, 1000, &Producer); // start ADC sampling, channel 0, 1000 Hz
-  NumCreated += OS_AddThread(&Display,128,0); 
+  NumCreated += OS_AddThread(&Display,128,1); 
   while(NumSamples < RUNLENGTH) { 
     for(t = 0; t < 64; t++){   // collect 64 ADC samples
       OS_Fifo_Get(&data);    // get from producer
@@ -275,15 +271,16 @@ int main(void){        // lab 3 real main
   OS_Fifo_Init(64);    // ***note*** 4 is not big enough*****
 
 //*******attach background tasks***********
+  OS_InitWorkers(2,2);   // threads that run the button jobs
   OS_AddButtonTask(&ButtonPush,2);
   OS_AddDownTask(&DownPush,3);
   OS_AddPeriodicThread(&DAS,PERIOD,1); // 2 kHz real time sampling
 
   NumCreated = 0 ;
 // create initial foreground threads
-  NumCreated += OS_AddThread(&Interpreter,128,2); 
-  NumCreated += OS_AddThread(&Consumer,128,1); 
-  NumCreated += OS_AddThread(&PID,128,3); 
+  NumCreated += OS_AddThread(&Interpreter,INTERPRETER_STACK_SIZE,3); 
+  NumCreated += OS_AddThread(&Consumer,128,2); 
+  NumCreated += OS_AddThread(&PID,128,4); 
  
   OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
   return 0;             // this never executes
@@ -545,38 +542,39 @@ void Thread6(void){  // foreground thread
   }
 }
 
-void Jitter(void)   // prints jitter information (write this)
+void Jitter(void)   // prints jitter information, in cycles
 {
-  char string[7], printInd[7];
-  int i;
-  OSuart_OutString(UART0_BASE,"Jitter Information:\n\r\n\r");
-  OSuart_OutString(UART0_BASE,"Jitter for Periodic Task 1:\n\r");
-  for(i = 0; i<JITTERSIZE; i++)
+  char string[12], printInd[12];
+  int i, id;
+  JitterType * jitterPt;
+  OSuart_OutString(UART0_BASE,"Jitter Information (cycles):\n\r\n\r");
+  for(id = 1; id <= NumPeriodic; id++)
   {
-    if(JitterHistogramA[i] != 0)
-	  {
-  	  Int2Str((i-32), printInd);
-  	  Int2Str(JitterHistogramA[i], string);
-  	  OSuart_OutString(UART0_BASE,printInd);
-  	  OSuart_OutString(UART0_BASE,": ");
+    jitterPt = &PeriodicTasks[id-1].jitter;
+    Int2Str(id, printInd);
+    OSuart_OutString(UART0_BASE,"Jitter for Periodic Task ");
+    OSuart_OutString(UART0_BASE,printInd);
+    OSuart_OutString(UART0_BASE,":\n\r");
+    for(i = 0; i<JITTER_BINS; i++)
+    {
+      if(jitterPt->histogram[i] != 0)
+      {
+        Int2Str((i << JITTER_SHIFT) - JITTER_OFFSET, printInd);
+        Int2Str(jitterPt->histogram[i], string);
+        OSuart_OutString(UART0_BASE,printInd);
+        OSuart_OutString(UART0_BASE,": ");
         OSuart_OutString(UART0_BASE,string);
-  	  OSuart_OutString(UART0_BASE,"\n\r"); 
-  	}
-  }
-  OSuart_OutString(UART0_BASE,"Jitter for Periodic Task 2:\n\r");
-  for(i = 0; i<JITTERSIZE; i++)
-  {
-    if(JitterHistogramB[i] != 0)
-  	{
-  	  Int2Str((i-32), printInd);
-  	  Int2Str(JitterHistogramB[i], string);
-  	  OSuart_OutString(UART0_BASE,printInd);
-   	  OSuart_OutString(UART0_BASE,": ");
-      OSuart_OutString(UART0_BASE,string);
-   	  OSuart_OutString(UART0_BASE,"\n\r"); 
-  	}
+        OSuart_OutString(UART0_BASE,"\n\r");
+      }
+    }
+    Int2Str(OS_JitterPercentile(id, 999), string);
+    OSuart_OutString(UART0_BASE,"p99.9: ");
+    OSuart_OutString(UART0_BASE,string);
+    Int2Str(jitterPt->misses, string);
+    OSuart_OutString(UART0_BASE," missed: ");
+    OSuart_OutString(UART0_BASE,string);
+    OSuart_OutString(UART0_BASE,"\n\r");
   }
-    
 }
 
 void Thread7(void){  // foreground thread
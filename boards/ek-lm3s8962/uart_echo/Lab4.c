@@ -24,6 +24,9 @@
 #include "string.h"
 #include "drivers/OS.h"
 #include "drivers/OSuart.h"
+#include "drivers/OS_defer.h"
+#include "drivers/OS_worker.h"
+#include "drivers/OS_periodic.h"
 #include "lm3s8962.h"
 #include "drivers/OSuart.h"
 
@@ -33,11 +36,6 @@ unsigned long FilterWork;   // number of digital filter calculations finished
 unsigned long NumSamples;   // incremented every sample
 unsigned long DataLost;     // data sent by Producer, but not received by Consumer
 
-extern unsigned long JitterHistogramA[];
-extern unsigned long JitterHistogramB[];
-extern long MaxJitterA;
-extern long MinJitterA;
-
 unsigned short SoundVFreq = 1;
 unsigned short SoundVTime = 0;
 unsigned short FilterOn = 1;
@@ -47,8 +45,6 @@ unsigned int Trigger = 0;
 
 Sema4Type MailBoxFull;
 Sema4Type MailBoxEmpty;
-Sema4Type SoundReady;
-Sema4Type SoundRead;
 
 #define GPIO_B0 (*((volatile unsigned long *)(0x40005004)))
 #define GPIO_B1 (*((volatile unsigned long *)(0x40005008)))
@@ -57,7 +53,15 @@ Sema4Type SoundRead;
 
 // 10-sec finite time experiment duration 
 #define RUNLENGTH 10000   // display results and quit when NumSamples==RUNLENGTH
-long x[256],y[256];         // input and output arrays for FFT
+typedef struct SoundFrame{
+  long x[256];                // ADC samples
+  long y[256];                // their FFT
+}SoundFrame;
+SoundFrame Frames[2];       // Consumer fills one while SoundDisplay plots the other
+MsgQueueType FreeFrames;    // frames for Consumer to fill
+MsgQueueType FullFrames;    // frames for SoundDisplay to plot
+void * FreeFrameSlots[2];
+void * FullFrameSlots[2];
 long xFilt[256];
 short data[256];
 void cr4_fft_256_stm32(void *pssOUT, void *pssIN, unsigned short Nbin);
@@ -157,23 +161,21 @@ unsigned short input;
 
 //------------------Task 2--------------------------------
 // background thread executes with select button
-// one foreground task created with button push
-// foreground treads run for 2 sec and die
+// one job run by a worker thread per button push
 // ***********ButtonWork*************
-void ButtonWork(void){
+void ButtonWork(unsigned long arg){
 unsigned long myId = OS_Id(); 
   oLED_Message(1,0,"NumCreated =",NumCreated); 
   oLED_Message(1,2,"DataLost   =",DataLost);
-  oLED_Message(1,3,"0.1u Jitter=",MaxJitterA-MinJitterA);
-  OS_Kill();  // done
-} 
+  oLED_Message(1,3,"Jitter p999=",OS_JitterPercentile(1,999));
+}
 
 //************ButtonPush*************
 // Called when Select Button pushed
-// Adds another foreground task
+// Hands ButtonWork to the worker pool
 // background threads execute once and return
 void ButtonPush(void){
-  if(OS_AddThread(&ButtonWork,100,1)){
+  if(OS_Submit(&ButtonWork,0)){
     NumCreated++; 
   }
 }
@@ -221,6 +223,7 @@ void Display(void);
 // outputs: none
 void Consumer(void){ 
 unsigned long data,DCcomponent; // 10-bit raw ADC sample, 0 to 1023
+SoundFrame * frame;
 unsigned int i;
 unsigned long t;  // time in ms
 unsigned long myId = OS_Id(); 
@@ -228,17 +231,17 @@ unsigned long myId = OS_Id();
   ADC_Collect(0, 10000, &Producer); // start ADC sampling, channel 0, 1000 Hz
 //  NumCreated += OS_AddThread(&Display,128,0); 
   while(NumSamples < RUNLENGTH) {
-    OS_Wait(&SoundRead); 
+    frame = OS_MsgQueue_Recv(&FreeFrames);   // a frame SoundDisplay is done with
     for(t = 0; t < 256; t++){   // collect 256 ADC samples
       while(!OS_Fifo_Get(&data));   // get from producer    
-      x[t] = data;           // real part is 0 to 1023, imaginary part is 0
+      frame->x[t] = data;           // real part is 0 to 1023, imaginary part is 0
 	  if(FilterOn)
 	  {
-        xFilt[t] = (long)Filter51((short)x[t]);
+        xFilt[t] = (long)Filter51((short)frame->x[t]);
 	  }
 	  else
 	  {
-	    xFilt[t] = (long)x[t];
+	    xFilt[t] = (long)frame->x[t];
 	  }
     }
 	for(i = 0; i < 256; i++)
@@ -246,9 +249,9 @@ unsigned long myId = OS_Id();
       xFilt[i] = ((xFilt[i]-423)*hanning[i])/1024;	// 423 is DC correction for 1.24 V out of 3 V.
 	}
 
-    cr4_fft_256_stm32(y,xFilt,256);  // complex FFT of last 256 ADC values
-	OS_Signal(&SoundReady);
-    DCcomponent = y[0]&0xFFFF; // Real part at frequency 0, imaginary part should be zero
+    cr4_fft_256_stm32(frame->y,xFilt,256);  // complex FFT of last 256 ADC values
+    DCcomponent = frame->y[0]&0xFFFF; // Real part at frequency 0, imaginary part should be zero
+    OS_MsgQueue_Send(&FullFrames, frame);   // SoundDisplay owns it now
     
 //	OS_Wait(&MailBoxEmpty);
 	OS_MailBox_Send(DCcomponent);
@@ -283,38 +286,39 @@ extern void Interpreter(void);    // just a prototype, link to your interpreter
 
 //--------------end of Task 5-----------------------------
 
-void Jitter(void)   // prints jitter information (write this)
+void Jitter(void)   // prints jitter information, in cycles
 {
-  char string[7], printInd[7];
-  int i;
-  OSuart_OutString(UART0_BASE,"Jitter Information:\n\r\n\r");
-  OSuart_OutString(UART0_BASE,"Jitter for Periodic Task 1:\n\r");
-  for(i = 0; i<JITTERSIZE; i++)
+  char string[12], printInd[12];
+  int i, id;
+  JitterType * jitterPt;
+  OSuart_OutString(UART0_BASE,"Jitter Information (cycles):\n\r\n\r");
+  for(id = 1; id <= NumPeriodic; id++)
   {
-    if(JitterHistogramA[i] != 0)
-	{
-	  Int2Str((i-32), printInd);
-	  Int2Str(JitterHistogramA[i], string);
-	  OSuart_OutString(UART0_BASE,printInd);
-	  OSuart_OutString(UART0_BASE,": ");
-      OSuart_OutString(UART0_BASE,string);
-	  OSuart_OutString(UART0_BASE,"\n\r"); 
-	}
-  }
-  OSuart_OutString(UART0_BASE,"Jitter for Periodic Task 2:\n\r");
-  for(i = 0; i<JITTERSIZE; i++)
-  {
-    if(JitterHistogramB[i] != 0)
-  	{
-  	  Int2Str((i-32), printInd);
-  	  Int2Str(JitterHistogramB[i], string);
-  	  OSuart_OutString(UART0_BASE,printInd);
-  	  OSuart_OutString(UART0_BASE,": ");
-      OSuart_OutString(UART0_BASE,string);
-  	  OSuart_OutString(UART0_BASE,"\n\r"); 
-  	}
+    jitterPt = &PeriodicTasks[id-1].jitter;
+    Int2Str(id, printInd);
+    OSuart_OutString(UART0_BASE,"Jitter for Periodic Task ");
+    OSuart_OutString(UART0_BASE,printInd);
+    OSuart_OutString(UART0_BASE,":\n\r");
+    for(i = 0; i<JITTER_BINS; i++)
+    {
+      if(jitterPt->histogram[i] != 0)
+      {
+        Int2Str((i << JITTER_SHIFT) - JITTER_OFFSET, printInd);
+        Int2Str(jitterPt->histogram[i], string);
+        OSuart_OutString(UART0_BASE,printInd);
+        OSuart_OutString(UART0_BASE,": ");
+        OSuart_OutString(UART0_BASE,string);
+        OSuart_OutString(UART0_BASE,"\n\r");
+      }
+    }
+    Int2Str(OS_JitterPercentile(id, 999), string);
+    OSuart_OutString(UART0_BASE,"p99.9: ");
+    OSuart_OutString(UART0_BASE,string);
+    Int2Str(jitterPt->misses, string);
+    OSuart_OutString(UART0_BASE," missed: ");
+    OSuart_OutString(UART0_BASE,string);
+    OSuart_OutString(UART0_BASE,"\n\r");
   }
-    
 }
 
 //**************oLED Graphing Voltage vs. Freq/Time*****************
@@ -322,20 +326,21 @@ void SoundDisplay(void)
 {
 
   static int index;
+  SoundFrame * frame;
   char *string;
   for(;;){
     if(SoundVFreq)
     {
-	    OS_Wait(&SoundReady);
+	    frame = OS_MsgQueue_Recv(&FullFrames);
 	  RIT128x96x4PlotClear(0,1023);
 		 
       for(index = 0; index < 128; index++)
    	  {
-	    if(x[index] > 1000)
+	    if(frame->x[index] > 1000)
 		{
 		  Trigger = 1;
 		}
-	    data[index] = (short)y[index];
+	    data[index] = (short)frame->y[index];
 		if(data[index] < 0)
 		{
 		  data[index] = 0;
@@ -357,31 +362,31 @@ void SoundDisplay(void)
 		
 	  RIT128x96x4ShowPlot();
 	  
-      OS_Signal(&SoundRead);
+      OS_MsgQueue_Send(&FreeFrames, frame);
     }
     else if(SoundVTime)
     {
-	  OS_Wait(&SoundReady);
+	  frame = OS_MsgQueue_Recv(&FullFrames);
 	  RIT128x96x4PlotClear(0,1023);
       for(index = 128; index < 256; index++) 
       {
-	    if(x[index] > 600)
+	    if(frame->x[index] > 600)
 		{
 		  Trigger = 1;
 		}
-        RIT128x96x4PlotPoint(x[index]);
+        RIT128x96x4PlotPoint(frame->x[index]);
 		RIT128x96x4PlotNext();
 
 		if(Trigger){
 		  if(SoundDumpInd < 200)
 		  {
-		    SoundDump[SoundDumpInd] = x[index];
+		    SoundDump[SoundDumpInd] = frame->x[index];
 		    SoundDumpInd++;
 		  }
 		}
       }
 	  RIT128x96x4ShowPlot();
-	  OS_Signal(&SoundRead);
+	  OS_MsgQueue_Send(&FreeFrames, frame);
     }
   }
   
@@ -394,8 +399,10 @@ int main(void){        // lab 3 real main
 
   OS_InitSemaphore(&MailBoxEmpty,1);
   OS_InitSemaphore(&MailBoxFull,0);
-  OS_InitSemaphore(&SoundReady,0);
-  OS_InitSemaphore(&SoundRead,1);
+  OS_MsgQueue_Create(&FreeFrames,FreeFrameSlots,2);
+  OS_MsgQueue_Create(&FullFrames,FullFrameSlots,2);
+  OS_MsgQueue_Send(&FreeFrames,&Frames[0]);
+  OS_MsgQueue_Send(&FreeFrames,&Frames[1]);
 
   DataLost = 0;        // lost data between producer and consumer
   NumSamples = 0;
@@ -406,13 +413,14 @@ int main(void){        // lab 3 real main
   OS_Fifo_Init(64);    // ***note*** 4 is not big enough*****
 
 //*******attach background tasks***********
+  OS_InitWorkers(1,1);   // thread that runs the button jobs
   OS_AddButtonTask(&ButtonPush,2);
   OS_AddDownTask(&DownPush,3);
   OS_AddPeriodicThread(&DAS,PERIOD,1); // 2 kHz real time sampling
 
   NumCreated = 0 ;
 // create initial foreground threads
-  NumCreated += OS_AddThread(&Interpreter,128,1); 
+  NumCreated += OS_AddThread(&Interpreter,INTERPRETER_STACK_SIZE,1); 
   NumCreated += OS_AddThread(&Consumer,128,1); 
   NumCreated += OS_AddThread(&SoundDisplay,128,1); 
  
@@ -30,10 +30,10 @@ unsigned long DataLost;     // data sent by Producer, but not received by Consum
 unsigned long PIDWork;      // current number of PID calculations finished
 unsigned long FilterWork;   // number of digital filter calculations finished
 
-extern unsigned long JitterHistogramA[];
-extern unsigned long JitterHistogramB[];
-extern long MaxJitterA;
-extern long MinJitterA;
+#define ROBOT_FIFOSIZE 512   // 0.5 s of samples at 1000 Hz
+#define ROBOT_BURST 16       // samples the consumers take at a time
+FifoType RobotFifo;          // from Producer to Robot and IdleTask
+unsigned long RobotFifoBuffer[ROBOT_FIFOSIZE];
 
 unsigned short SoundVFreq = 1;
 unsigned short SoundVTime = 0;
@@ -59,7 +59,8 @@ int Running;                // true while robot is running
 // inputs:  none
 // outputs: none
 void Robot(void){   
-unsigned long data;      // ADC sample, 0 to 1023
+unsigned long data[ROBOT_BURST];      // ADC samples, 0 to 1023
+unsigned long n, j;
 unsigned long voltage;   // in mV,      0 to 3000
 unsigned long time = 0;      // in 10msec,  0 to 1000 
 unsigned long t=0;
@@ -71,13 +72,16 @@ unsigned int i;
   eFile_Create("Robot");
   eFile_RedirectToFile("Robot");
   OSuart_OutString(UART0_BASE, "time(sec)\tdata(volts)\n\r");
-  for(i = 1000; i > 0; i--){
-    t++;
-    time+=OS_Time()/10000;            // 10ms resolution in this OS
-    while(!OS_Fifo_Get(&data));        // 1000 Hz sampling get from producer
-    voltage = (300*data)/1024;   // in mV
-    sprintf(string, "%0u.%02u\t\t%0u.%03u\n\r",time/100,time%100,voltage/1000,voltage%1000);
-    OSuart_OutString(UART0_BASE, string);
+  for(i = 1000; i > 0; i -= n){
+    // sleeps until the producer puts, then takes the whole burst
+    n = OS_Fifo_RecvN(&RobotFifo, data, (i < ROBOT_BURST) ? i : ROBOT_BURST);
+    for(j = 0; j < n; j++){
+      t++;
+      time+=OS_Time()/10000;            // 10ms resolution in this OS
+      voltage = (300*data[j])/1024;   // in mV
+      sprintf(string, "%0u.%02u\t\t%0u.%03u\n\r",time/100,time%100,voltage/1000,voltage%1000);
+      OSuart_OutString(UART0_BASE, string);
+    }
   }
   eFile_EndRedirectToFile();
   OSuart_OutString(UART0_BASE, "done.\n\r");										    
@@ -100,7 +104,7 @@ unsigned int i;
 // outputs: none
 void Producer(unsigned short data){  
   if(Running){
-    if(OS_Fifo_Put(data)){     // send to Robot
+    if(OS_Fifo_Send(&RobotFifo, data)){     // send to Robot
       NumSamples++;
     } else{ 
       DataLost++;
@@ -115,7 +119,8 @@ void Producer(unsigned short data){
 // outputs: none
 unsigned long Idlecount=0;
 void IdleTask(void){
-  unsigned long data;      // ADC sample, 0 to 1023
+  unsigned long data[ROBOT_BURST];      // ADC samples, 0 to 1023
+  unsigned long n, j;
   unsigned long voltage;   // in mV,      0 to 3000
   unsigned long time = 0;      // in 10msec,  0 to 1000 
   unsigned long t=0;
@@ -126,13 +131,16 @@ void IdleTask(void){
   eFile_Create("Robot2");
   eFile_RedirectToFile("Robot2");
   OSuart_OutString(UART0_BASE, "time(sec)\tdata(volts)\n\r");
-  for(i = 1000; i > 0; i--){
-    t++;
-    time+=OS_Time()/10000;            // 10ms resolution in this OS
-    while(!OS_Fifo_Get(&data));        // 1000 Hz sampling get from producer
-    voltage = (300*data)/1024;   // in mV
-    sprintf(string, "%0u.%02u\t\t%0u.%03u\n\r",time/100,time%100,voltage/1000,voltage%1000);
-    OSuart_OutString(UART0_BASE, string);
+  for(i = 1000; i > 0; i -= n){
+    // sleeps until the producer puts, then takes the whole burst
+    n = OS_Fifo_RecvN(&RobotFifo, data, (i < ROBOT_BURST) ? i : ROBOT_BURST);
+    for(j = 0; j < n; j++){
+      t++;
+      time+=OS_Time()/10000;            // 10ms resolution in this OS
+      voltage = (300*data[j])/1024;   // in mV
+      sprintf(string, "%0u.%02u\t\t%0u.%03u\n\r",time/100,time%100,voltage/1000,voltage%1000);
+      OSuart_OutString(UART0_BASE, string);
+    }
   }
 
   eFile_EndRedirectToFile();
@@ -159,8 +167,8 @@ extern void Interpreter(void);
 void ButtonPush(void){
   if(Running==0){
     Running = 1;  // prevents you from starting two robot threads
-    NumCreated += OS_AddThread(&Robot,128,1);  // start a 20 second run
-	NumCreated += OS_AddThread(&IdleTask,128,1);  // start a 20 second run
+    NumCreated += OS_AddThread(&Robot,256,1);  // start a 20 second run
+	NumCreated += OS_AddThread(&IdleTask,256,1);  // start a 20 second run
   }
 }
 //************DownPush*************
@@ -178,7 +186,7 @@ int main(void){        // lab 5 real main
   NumSamples = 0;
 
 //********initialize communication channels
-  OS_Fifo_Init(512);    // ***note*** 4 is not big enough*****
+  OS_Fifo_Create(&RobotFifo, RobotFifoBuffer, ROBOT_FIFOSIZE);
   ADC_Open();
   ADC_Collect(0, 1000, &Producer); // start ADC sampling, channel 0, 1000 Hz 
 
@@ -189,7 +197,7 @@ int main(void){        // lab 5 real main
 
   NumCreated = 0 ;
 // create initial foreground threads
-  NumCreated += OS_AddThread(&Interpreter,128,2); 
+  NumCreated += OS_AddThread(&Interpreter,INTERPRETER_STACK_SIZE,2); 
 //  NumCreated += OS_AddThread(&IdleTask,128,7);  // runs when nothing useful to do
  
   OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
@@ -244,7 +252,7 @@ void TestDisk(void){  DSTATUS result;  unsigned short block;  int i; unsigned lo
   OS_Kill();
 }
 void RunTest(void){
-  NumCreated += OS_AddThread(&TestDisk,128,1);  
+  NumCreated += OS_AddThread(&TestDisk,1024,1);  
 }
 
 void TestFile(void){   int i; char data; DSTATUS result; 
@@ -309,7 +317,7 @@ int testmain1(void){   // testmain1
   
   NumCreated = 0 ;
 // create initial foreground threads
-  NumCreated += OS_AddThread(&TestFile,128,1);  
+  NumCreated += OS_AddThread(&TestFile,1024,1);  
   NumCreated += OS_AddThread(&IdleTask,128,1); 
  
   OS_Launch(TIME_1MS); // doesn't return, interrupts enabled in here
@@ -329,9 +337,51 @@ int testmain2(void){
   
   NumCreated = 0 ;
 // create initial foreground threads
-  NumCreated += OS_AddThread(&TestFile,128,1);  
+  NumCreated += OS_AddThread(&TestFile,1024,1);  
   NumCreated += OS_AddThread(&IdleTask,128,3); 
  
   OS_Launch(10*TIME_1MS); // doesn't return, interrupts enabled in here
   return 0;               // this never executes
 }
+
+
+
+//******************* test main3 **********
+// Wake-to-run latency of a blocked consumer
+// The ADC ISR puts 1 kHz samples in the OS FIFO through Producer, and a
+// high priority consumer blocks in OS_Fifo_Get.  Two low priority threads
+// keep the processor busy.  The interpreter command Latency shows how long
+// the consumer took to run after each put.  Build with OS_PREEMPT_ON_WAKE
+// set to 0 in OS.h for the old behavior, where the consumer waited for the
+// end of the TIMESLICE.
+unsigned long BusyCount;
+void BusyTask(void){
+  while(1){
+    BusyCount++;
+  }
+}
+void LatencyConsumer(void){
+  unsigned long data;
+  while(1){
+    OS_Fifo_Get(&data);       // blocks until the ADC ISR puts a sample
+    FilterWork++;
+  }
+}
+int testmain3(void){ 
+  OS_Init();           // initialize, disable interrupts
+  Running = 1;         // Producer puts every sample
+  DataLost = 0;
+  NumSamples = 0;
+  OS_Fifo_Init(MAX_OS_FIFOSIZE);
+  ADC_Collect(0, 1000, &Producer); // start ADC sampling, channel 0, 1000 Hz 
+
+  NumCreated = 0 ;
+// create initial foreground threads
+  NumCreated += OS_AddThread(&LatencyConsumer,128,1);  
+  NumCreated += OS_AddThread(&Interpreter,INTERPRETER_STACK_SIZE,2); 
+  NumCreated += OS_AddThread(&BusyTask,128,3); 
+  NumCreated += OS_AddThread(&BusyTask,128,3); 
+ 
+  OS_Launch(TIMESLICE); // doesn't return, interrupts enabled in here
+  return 0;               // this never executes
+}
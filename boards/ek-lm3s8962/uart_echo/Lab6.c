@@ -33,11 +33,6 @@ unsigned long DataLost;     // data sent by Producer, but not received by Consum
 unsigned long PIDWork;      // current number of PID calculations finished
 unsigned long FilterWork;   // number of digital filter calculations finished
 
-extern unsigned long JitterHistogramA[];
-extern unsigned long JitterHistogramB[];
-extern long MaxJitterA;
-extern long MinJitterA;
-
 unsigned short SoundVFreq = 1;
 unsigned short SoundVTime = 0;
 unsigned short FilterOn = 1;
@@ -224,7 +219,7 @@ int main(void){
   NumSamples = 0;
 
 //********initialize communication channels
-  OS_Fifo_Init(512);    // ***note*** 4 is not big enough*****
+  OS_Fifo_Init(MAX_OS_FIFOSIZE);    // ***note*** 4 is not big enough*****
 
   //Tachometer_Init(2);
 
@@ -240,7 +235,7 @@ int main(void){
 // create initial foreground threads
 //  NumCreated += OS_AddThread(&CAN,128,2); 
   NumCreated += OS_AddThread(&IRSensor,128,2);  // runs when nothing useful to do
-  NumCreated += OS_AddThread(&Interpreter,128,2);
+  NumCreated += OS_AddThread(&Interpreter,INTERPRETER_STACK_SIZE,2);
 
 //  NumCreated += OS_AddThread(&IdleTask,128,2);  // runs when nothing useful to do
 //  NumCreated += OS_AddThread(&Display,128,2);
@@ -37,13 +37,10 @@ unsigned long FilterWork;   // number of digital filter calculations finished
 #define MAX_SPEED 20
 #define MIN_SPEED 0
 
-extern unsigned long JitterHistogramA[];
-extern unsigned long JitterHistogramB[];
 extern unsigned long DebugAngle;
-extern long MaxJitterA;
-extern long MinJitterA;
 
 extern unsigned long RunningCount;
+extern unsigned long CpuLoad1s;   // CPU load over the last second, in 0.1%
 
 unsigned short SoundVFreq = 1;
 unsigned short SoundVTime = 0;
@@ -130,7 +127,9 @@ unsigned long pingFirstTime = 0;
 unsigned long pingSecondTime = 0;
 unsigned long pingCounter = 0;
 
+#define DISPLAY_PERIOD 100    // ms between OLED updates
 void Display(void){
+	unsigned long lastWake = OS_MsTime();
 	while(1){
   	oLED_Message(0, 0, "IR Front Left: ", Sensors.ir_front_left);
 	oLED_Message(0, 1, "IR Side Left: ", Sensors.ir_side_left);
@@ -140,7 +139,8 @@ void Display(void){
 	oLED_Message(1, 1, "Ping: ", Sensors.ping);
 	oLED_Message(1, 2, "SpeedLeft: ", SpeedLeft);
 	oLED_Message(1, 3, "SpeedRight: ", SpeedRight);
-
+	oLED_Message(0, 4, "CPU Load %: ", CpuLoad1s/10);
+	OS_SleepUntil(&lastWake, DISPLAY_PERIOD);
 	}
 }
 
@@ -151,10 +151,12 @@ void Display(void){
 
 unsigned char pingCounterFlag = 0;
 
+#define CATBOT_PERIOD 3       // ms per steering update
 void CatBot(void){
   unsigned long i;
   unsigned short localPing;
   unsigned short localTach;
+  unsigned long lastWake = OS_MsTime();
 
   while(1){
 
@@ -221,7 +223,7 @@ void CatBot(void){
     motorBuffer[1] = SpeedLeft;
     motorBuffer[2] = SpeedRight;
 	CAN_Send(motorBuffer);
-	SysCtlDelay(SysCtlClockGet()/1000);
+	OS_SleepUntil(&lastWake, CATBOT_PERIOD);
 
 	if(RunningCount > RUN_TIME){
 		while(1){
@@ -230,7 +232,7 @@ void CatBot(void){
     		motorBuffer[1] = SpeedLeft;
     		motorBuffer[2] = SpeedRight;
 			CAN_Send(motorBuffer);
-			SysCtlDelay(SysCtlClockGet()/1000);
+			OS_SleepUntil(&lastWake, CATBOT_PERIOD);
 		}
 	}
 
@@ -247,23 +249,25 @@ void CatBot(void){
   }
 }
 
+#define PWM_TICK 46           // clock cycles per PWM count (old timer prescale)
 unsigned char OnOffFlag;
 unsigned long PWMduty;
+int PWMThread;                // periodic thread id of Fake_PWM
 void Fake_PWM(void){
-  unsigned long totDutyPeriod = 21739;  //for 50Mhz and 45 timer prescale
+  unsigned long totDutyPeriod = 21739;  //for 50Mhz and 46 cycle PWM count
 
   if(OnOffFlag){
     // Toggle bit high
     GPIOPinWrite(GPIO_PORTD_BASE, GPIO_PIN_2, 0x4);
 	// Load pediod with duty cycle
-	TimerLoadSet(TIMER3_BASE, TIMER_A, PWMduty);
+	OS_SetPeriodicPeriod(PWMThread, PWMduty*PWM_TICK);
 	OnOffFlag = 0;
   }
   else{
 	// Toggle bit low  
 	GPIOPinWrite(GPIO_PORTD_BASE, GPIO_PIN_2, 0);
 	// Load period with total PWM period - duty cycle
-	TimerLoadSet(TIMER3_BASE, TIMER_A, totDutyPeriod - PWMduty);
+	OS_SetPeriodicPeriod(PWMThread, (totDutyPeriod - PWMduty)*PWM_TICK);
 	OnOffFlag = 1; 
   }  
 }
@@ -275,7 +279,7 @@ int main(void){
   NumSamples = 0;
 
 //********initialize communication channels
-  OS_Fifo_Init(512);    // ***note*** 4 is not big enough*****
+  OS_Fifo_Init(MAX_OS_FIFOSIZE);    // ***note*** 4 is not big enough*****
 
 //*******attach background tasks***********
   OS_AddButtonTask(&ButtonPush,2);
@@ -284,7 +288,7 @@ int main(void){
   OS_BumperInit();
   CAN_Init();
   Servo_Init();
-  OS_AddPeriodicThread(&Fake_PWM, 100, 1);
+  PWMThread = OS_AddPeriodicThread(&Fake_PWM, 100*PWM_TICK, 1);
 
   NumCreated = 0 ;
 // create initial foreground threads
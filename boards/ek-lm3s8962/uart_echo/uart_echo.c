@@ -418,7 +418,7 @@ main_orig(void)
   //
   oLED_Message(1, 4, "RT OS LAB:", 1);
   ADC_Open();
-  OS_AddPeriodicThread(&dummy, 1, 1);
+  OS_AddPeriodicThread(&dummy, TIME_1MS, 1);
 
   while(1)
   {    
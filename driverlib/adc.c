@@ -1503,6 +1503,13 @@ ADC_Open(void)
   // ADC Peripheral must be enabled before use
   //
   SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
+
+  // The sample tasks call the OS, so every sequencer interrupt must be
+  // masked by OS critical sections
+  IntPrioritySet(INT_ADC0SS0, OS_KERNEL_PRIORITY << 5);
+  IntPrioritySet(INT_ADC0SS1, OS_KERNEL_PRIORITY << 5);
+  IntPrioritySet(INT_ADC0SS2, OS_KERNEL_PRIORITY << 5);
+  IntPrioritySet(INT_ADC0SS3, OS_KERNEL_PRIORITY << 5);
   return(1);
 }
 
@@ -1659,8 +1666,11 @@ ADC_Collect_All(unsigned int fs, void (*task0)(unsigned short), void (*task1)(un
   ADCIntEnable(ADC0_BASE, 2);
   ADCIntEnable(ADC0_BASE, 3);
 
-  // Set Priority for the ADC interrupt
-  IntPrioritySet(INT_ADC0SS3, 1);
+  // Set Priority for the ADC interrupts, the sample tasks call the OS
+  IntPrioritySet(INT_ADC0SS0, OS_KERNEL_PRIORITY << 5);
+  IntPrioritySet(INT_ADC0SS1, OS_KERNEL_PRIORITY << 5);
+  IntPrioritySet(INT_ADC0SS2, OS_KERNEL_PRIORITY << 5);
+  IntPrioritySet(INT_ADC0SS3, OS_KERNEL_PRIORITY << 5);
 
   // Clear the interrupt status flag.  This is done to make sure the
   // interrupt flag is cleared before we sample. 
@@ -1770,8 +1780,8 @@ ADC_Collect(unsigned int channelNum, unsigned int fs, void (*task)(unsigned shor
   // Allow ADC to generate an interrupt signal.
   ADCIntEnable(ADC0_BASE, 3);
 
-  // Set Priority for the ADC interrupt
-  IntPrioritySet(INT_ADC0SS3, 1);
+  // Set Priority for the ADC interrupt, the sample task calls the OS
+  IntPrioritySet(INT_ADC0SS3, OS_KERNEL_PRIORITY << 5);
 
   // Clear the interrupt status flag.  This is done to make sure the
   // interrupt flag is cleared before we sample. 